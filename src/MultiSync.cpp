@@ -1278,7 +1278,13 @@ void MultiSync::SendSeqSyncPacket(const std::string &filename, int frames, float
 	spkt->secondsElapsed = seconds;
 	strcpy(spkt->filename, filename.c_str());
 
-	SendControlPacket(outBuf, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length());
+	// called as the frame starts, let remotes lock onto our clock
+	SyncPktTimestamp *tpkt = (SyncPktTimestamp*)(spkt->filename + filename.length() + 1);
+	memcpy(tpkt->magic, SYNC_PKT_TIMESTAMP_MAGIC, sizeof(tpkt->magic));
+	tpkt->masterTime = GetMonotonicTime();
+	cpkt->extraDataLen += sizeof(SyncPktTimestamp);
+
+	SendControlPacket(outBuf, sizeof(ControlPkt) + sizeof(SyncPkt) + filename.length() + sizeof(SyncPktTimestamp));
 }
 
 void MultiSync::SendMediaOpenPacket(const std::string &filename)
@@ -2240,6 +2246,10 @@ void MultiSync::ProcessSyncPacket(ControlPkt *pkt, int len, MultiSyncStats *stat
 		return;
 	}
 
+    if (m_syncMaster != stats->sourceIP) {
+        // a different master, its clock has nothing to do with the old one
+        MasterFrameClock::INSTANCE.Reset();
+    }
     m_syncMaster = stats->sourceIP;
 
 	SyncPkt *spkt = (SyncPkt*)(((char*)pkt) + sizeof(ControlPkt));
@@ -2264,6 +2274,7 @@ void MultiSync::ProcessSyncPacket(ControlPkt *pkt, int len, MultiSyncStats *stat
 								 if (secondsElapsed < 0)
 									secondsElapsed = 0.0;
 
+								 ProcessSyncTimestamp(pkt, spkt, stats);
 								 SyncSyncedSequence(spkt->filename,
 									spkt->frameNumber, secondsElapsed);
                                  stats->pktSyncSeqSync++;
@@ -2292,6 +2303,28 @@ void MultiSync::ProcessSyncPacket(ControlPkt *pkt, int len, MultiSyncStats *stat
 	}
 }
 
+/*
+ * Feed the master clock tracking from the timestamp following the
+ * filename, if the master sent one
+ */
+void MultiSync::ProcessSyncTimestamp(ControlPkt *pkt, SyncPkt *spkt, MultiSyncStats *stats)
+{
+	int nameLen = pkt->extraDataLen - offsetof(SyncPkt, filename);
+	nameLen = strnlen(spkt->filename, nameLen);
+
+	int timestampOffset = offsetof(SyncPkt, filename) + nameLen + 1;
+	if (pkt->extraDataLen < (timestampOffset + sizeof(SyncPktTimestamp)))
+		return;
+
+	SyncPktTimestamp *tpkt = (SyncPktTimestamp*)(((char*)spkt) + timestampOffset);
+	if (memcmp(tpkt->magic, SYNC_PKT_TIMESTAMP_MAGIC, sizeof(tpkt->magic)))
+		return;
+
+	MasterFrameClock::INSTANCE.AddSyncPoint(spkt->frameNumber, tpkt->masterTime, GetMonotonicTime());
+	MasterFrameClock::INSTANCE.GetStats(stats->clock);
+	stats->pktSyncSeqTimestamped++;
+}
+
 /*
  *
  */
@@ -2522,6 +2555,7 @@ MultiSyncStats::MultiSyncStats(std::string ip, std::string host)
     pktSyncSeqStart(0),
     pktSyncSeqStop(0),
     pktSyncSeqSync(0),
+    pktSyncSeqTimestamped(0),
     pktSyncMedOpen(0),
     pktSyncMedStart(0),
     pktSyncMedStop(0),
@@ -2566,6 +2600,19 @@ Json::Value MultiSyncStats::toJSON()
     result["pktFPPCommand"] = pktFPPCommand;
     result["pktError"] = pktError;
 
+    if (pktSyncSeqTimestamped) {
+        // how well this system is locked onto the master's clock
+        result["pktSyncSeqTimestamped"] = pktSyncSeqTimestamped;
+        result["clockLocked"] = clock.locked;
+        result["clockOffset"] = (Json::Int64)clock.offset;
+        result["clockDriftPPM"] = clock.driftPPM;
+        result["clockJitter"] = clock.jitter;
+        result["framePeriod"] = clock.framePeriod;
+        result["phaseError"] = clock.phaseError;
+        result["avgPhaseError"] = clock.avgPhaseError;
+        result["maxPhaseError"] = clock.maxPhaseError;
+    }
+
     return result;
 }
 
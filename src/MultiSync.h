@@ -34,6 +34,7 @@
 #include <set>
 
 #include "settings.h"
+#include "channeloutput/MasterFrameClock.h"
 
 
 #define FPP_CTRL_PORT 32320
@@ -73,6 +74,15 @@ typedef struct __attribute__((packed)) {
 	                         // (data may continue past this header)
 } SyncPkt;
 
+// Optionally follows the filename of a sequence SYNC_PKT_SYNC.  Remotes
+// that don't know about it ignore anything after the filename.
+#define SYNC_PKT_TIMESTAMP_MAGIC "FPTS"
+
+typedef struct __attribute__((packed)) {
+	char     magic[4];       // 'FPTS'
+	uint64_t masterTime;     // Master's monotonic clock in us when the frame started
+} SyncPktTimestamp;
+
 typedef enum systemType {
 	kSysTypeUnknown                      = 0x00,
 	kSysTypeFPP                          = 0x01,
@@ -163,6 +173,7 @@ class MultiSyncStats {
     uint32_t          pktSyncSeqStart;
     uint32_t          pktSyncSeqStop;
     uint32_t          pktSyncSeqSync;
+    uint32_t          pktSyncSeqTimestamped;
     uint32_t          pktSyncMedOpen;
     uint32_t          pktSyncMedStart;
     uint32_t          pktSyncMedStop;
@@ -172,6 +183,7 @@ class MultiSyncStats {
     uint32_t          pktPlugin;
     uint32_t          pktFPPCommand;
     uint32_t          pktError;
+    MasterClockStats  clock;
 };
 
 class MultiSyncPlugin {
@@ -310,6 +322,7 @@ class MultiSync {
     void DiscoverIPViaHTTP(const std::string &ip, bool allowUnknown = false);
 
     void ProcessSyncPacket(ControlPkt *pkt, int len, MultiSyncStats *stats);
+    void ProcessSyncTimestamp(ControlPkt *pkt, SyncPkt *spkt, MultiSyncStats *stats);
     void ProcessCommandPacket(ControlPkt *pkt, int len, MultiSyncStats *stats);
     void ProcessPingPacket(ControlPkt *pkt, int len, MultiSyncStats *stats);
     void ProcessPluginPacket(ControlPkt *pkt, int len, MultiSyncStats *stats);
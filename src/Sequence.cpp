@@ -50,6 +50,10 @@ using namespace std::literals::chrono_literals;
 #include "mediaoutput/SDLOut.h"
 
 #define SEQUENCE_CACHE_FRAMECOUNT 40
+// automatic read ahead budget, never more than this or more than
+// 1/READ_AHEAD_MEM_FRACTION of the memory that is currently available
+#define MAX_AUTO_READ_AHEAD (32 * 1024 * 1024)
+#define READ_AHEAD_MEM_FRACTION 16
 
 Sequence *sequence = NULL;
 Sequence::Sequence()
@@ -64,7 +68,13 @@ Sequence::Sequence()
     m_seqSingleStepBack(0),
     m_seqRefreshRate(20),
     m_seqLastControlValue(0),
+    m_pendingPreset(0),
     m_remoteBlankCount(0),
+    m_dirtyBaseFrame(-1),
+    m_freshBaseData(false),
+    m_prepareFreshBaseData(false),
+    m_secondBuffer(nullptr),
+    m_bridgeModified(false),
     m_readThread(nullptr),
     m_lastFrameRead(-1),
     m_doneRead(false),
@@ -74,7 +84,10 @@ Sequence::Sequence()
     m_seqFilename(""),
     m_bridgeData(nullptr)
 {
-    memset(m_seqData, 0, sizeof(m_seqData));
+    memset(m_seqDataBuffer, 0, sizeof(m_seqDataBuffer));
+    m_seqData = m_seqDataBuffer;
+    m_outputData = m_seqDataBuffer;
+    m_unreadRanges.clear();
     for (int x = 0; x < 4; x++) {
         m_seqData[FPPD_OFF_CHANNEL + x] = 0;
         m_seqData[FPPD_WHITE_CHANNEL] = 0xFF;
@@ -96,19 +109,19 @@ Sequence::~Sequence()
     if (m_seqFile) {
         delete m_seqFile;
     }
-    if (m_bridgeData) {
-        free(m_bridgeData);
+    if (m_secondBuffer) {
+        free(m_secondBuffer);
     }
 }
 void Sequence::clearCaches() {
     while (!frameCache.empty()) {
         if (frameCache.front() != m_lastFrameData)
-            delete frameCache.front();
+            frameCache.front()->release();
         frameCache.pop_front();
     }
     while (!pastFrameCache.empty()) {
         if (pastFrameCache.front() != m_lastFrameData)
-            delete pastFrameCache.front();
+            pastFrameCache.front()->release();
         pastFrameCache.pop_front();
     }
 }
@@ -132,7 +145,7 @@ void Sequence::SetLastFrameData(FSEQFile::FrameData *data) {
         }
 
         if (!found)
-            delete m_lastFrameData;
+            m_lastFrameData->release();
     }
 
     m_lastFrameData = data;
@@ -193,7 +206,7 @@ void Sequence::ReadFramesLoop() {
                         lock.lock();
                     } else {
                         //a skip is in progress, we don't need this frame anymore
-                        delete fd;
+                        fd->release();
                     }
                 }
             } else {
@@ -285,6 +298,7 @@ int Sequence::OpenSequenceFile(const std::string &filename, int startFrame, int
     }
 
     m_seqFile = nullptr;
+    long long openStart = GetTime();
     FSEQFile *seqFile = FSEQFile::openFSEQFile(tmpFilename);
     if (seqFile == NULL) {
         LogErr(VB_SEQUENCE, "Error opening sequence file: %s. FSEQFile::openFSEQFile returned NULL\n",
@@ -303,7 +317,16 @@ int Sequence::OpenSequenceFile(const std::string &filename, int startFrame, int
         if (m_lastFrameRead < -1) m_lastFrameRead = -1;
     }
 
+    seqFile->setReadAheadBudget(GetReadAheadBudget(seqFile));
     seqFile->prepareRead(GetOutputRanges(), startFrame < 0 ? 0 : startFrame);
+    DirtyChannelRanges provided;
+    provided.clear();
+    provided.add(seqFile->getRangesToRead());
+    m_unreadRanges.clear();
+    m_unreadRanges.add(GetOutputRanges());
+    m_unreadRanges.remove(provided);
+    LogDebug(VB_SEQUENCE, "Opened sequence %s in %.3fms\n",
+             filename.c_str(), (GetTime() - openStart) / 1000.0);
     // Calculate duration
     m_seqMSRemaining = seqFile->getNumFrames() * seqFile->getStepTime();
     m_seqMSDuration = m_seqMSRemaining;
@@ -331,6 +354,42 @@ int Sequence::OpenSequenceFile(const std::string &filename, int startFrame, int
     return 1;
 }
 
+/*
+ * Memory the fseq reader may use to decompress ahead of playback.  By
+ * default it's sized so a small sequence or a low memory system like a
+ * Pi Zero or BBB doesn't reserve more than it can use or spare.
+ */
+uint64_t Sequence::GetReadAheadBudget(FSEQFile *seqFile) {
+    int mb = getSettingInt("fseqReadAheadMB", -1);
+    if (mb >= 0) {
+        return (uint64_t)mb * 1024 * 1024;
+    }
+
+    uint64_t available = 0;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f) {
+        char line[128];
+        unsigned long long kb;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+                available = kb * 1024;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    if (!available) {
+        available = (uint64_t)sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    }
+
+    uint64_t budget = std::min((uint64_t)MAX_AUTO_READ_AHEAD, available / READ_AHEAD_MEM_FRACTION);
+    // no point holding more than the whole decompressed sequence
+    budget = std::min(budget, (uint64_t)seqFile->getChannelCount() * seqFile->getNumFrames());
+    LogDebug(VB_SEQUENCE, "Sequence read ahead budget %" PRIu64 " bytes, %" PRIu64 " bytes available\n",
+             budget, available);
+    return budget;
+}
+
 void Sequence::StartSequence() {
     if (!IsSequenceRunning() && m_seqFile) {
         if (getFPPmode() == MASTER_MODE) {
@@ -378,7 +437,7 @@ void Sequence::SeekSequenceFile(int frameNumber) {
     }
     while (!frameCache.empty() && frameCache.front()->frame < frameNumber) {
         if (frameCache.front() != m_lastFrameData)
-            delete frameCache.front();
+            frameCache.front()->release();
         frameCache.pop_front();
     }
     if (!frameCache.empty() && frameNumber < frameCache.front()->frame) {
@@ -423,12 +482,20 @@ void Sequence::BlankSequenceData(void) {
     LogDebug(VB_SEQUENCE, "BlankSequenceData()\n");
     for (auto &a : GetOutputRanges()) {
         memset(&m_seqData[a.first], 0, a.second);
+        if (m_outputData != m_seqData) {
+            memset(&m_outputData[a.first], 0, a.second);
+        }
     }
     if (m_bridgeData) {
+        std::unique_lock<std::mutex> lock(m_bridgeDirtyLock);
         for (auto &a : GetOutputRanges()) {
             memset(&m_bridgeData[a.first], 0, a.second);
         }
+        m_bridgeDirtyRanges.setAllDirty();
+        m_bridgeStaleRanges.clear();
     }
+    m_dirtyRanges.setAllDirty();
+    m_dirtyBaseFrame = -1;
 
     std::unique_lock<std::mutex> lock(frameCacheLock);
     SetLastFrameData(nullptr);
@@ -453,9 +520,22 @@ void Sequence::SingleStepSequenceBack(void) {
     m_seqSingleStepBack = 1;
 }
 
-void Sequence::ReadSequenceData(bool forceFirstFrame) {
+/*
+ * If deferred is passed, closing or blanking the sequence is left to the
+ * caller, who is told by setting deferred and must call ReadSequenceData
+ * again without it.  The pipelined output thread reads on a worker thread
+ * and the blanking must not happen while a frame is being sent.
+ */
+void Sequence::ReadSequenceData(bool forceFirstFrame, bool *deferred) {
     LogExcess(VB_SEQUENCE, "ReadSequenceData()\n");
     std::unique_lock<std::recursive_mutex> seqLock(m_sequenceLock);
+    if (m_outputData != m_seqData) {
+        // pipelined, this buffer holds the frame before the one being sent.
+        // Bring the channels the sequence doesn't provide up to date or
+        // any overlays/effects on them would alternate between the two
+        // buffers' values.
+        CopyChannelRanges(m_seqData, m_outputData, m_unreadRanges);
+    }
     if (!forceFirstFrame && m_seqStarting) {
         return;
     }
@@ -500,7 +580,7 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
             frameCache.pop_front();
             if (pastFrameCache.size() > 20) {
                 if (pastFrameCache.front() != m_lastFrameData)
-                    delete pastFrameCache.front();
+                    pastFrameCache.front()->release();
                 pastFrameCache.pop_front();
             }
             pastFrameCache.push_back(data);
@@ -509,11 +589,16 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
             frameLoadSignal.notify_all();
             
             data->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+            MarkFrameDirty(data);
             SetChannelOutputFrameNumber(data->frame);
             m_seqMSElapsed = data->frame * m_seqStepTime;
             m_seqMSRemaining = m_seqMSDuration - m_seqMSElapsed;
             m_dataProcessed = false;
         } else if (m_doneRead) {
+            if (deferred) {
+                *deferred = true;
+                return;
+            }
             lock.unlock();
             m_seqMSElapsed = m_seqMSDuration;
             m_seqMSRemaining = 0;
@@ -526,12 +611,15 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
                     //and copy the last frame data
                     SetLastFrameData(pastFrameCache.back());
                     pastFrameCache.back()->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+                    MarkFrameDirty(pastFrameCache.back());
                     m_dataProcessed = false;
                 }
             }
             lock.unlock();
             frameLoadSignal.notify_all();
         }
+    } else if (deferred) {
+        *deferred = true;
     } else {
         if (m_blankBetweenSequences) {
             BlankSequenceData();
@@ -554,34 +642,62 @@ void Sequence::ReadSequenceData(bool forceFirstFrame) {
     }
 }
 
-void Sequence::ProcessSequenceData(int ms, int checkControlChannels) {
+void Sequence::ProcessSequenceData(int ms, int checkControlChannels, bool prepare) {
     static unsigned int controlChannel = (unsigned int)getSettingInt("PresetControlChannel");
 
     if (m_dataProcessed) {
         // we shouldn't normally be reprocessing the same data, so
         // if we are then see if we can start with a pristine copy
         std::unique_lock<std::mutex> lock(frameCacheLock);
-        if (m_lastFrameData)
+        if (m_lastFrameData) {
             m_lastFrameData->readFrame((uint8_t*)m_seqData, FPPD_MAX_CHANNELS);
+            MarkFrameDirty(m_lastFrameData);
+        } else if (m_outputData != m_seqData) {
+            // pipelined, this buffer holds the frame before the one being
+            // sent so start from the one being sent
+            for (auto &a : GetOutputRanges()) {
+                memcpy(&m_seqData[a.first], &m_outputData[a.first], a.second);
+            }
+        }
     }
+    // the dirty ranges are only known if the base sequence data was
+    // rewritten this frame, otherwise m_seqData still holds last frame's
+    // processed data
+    bool freshBaseData = m_freshBaseData;
+    m_freshBaseData = false;
+
+    // Sample what modifies the frame once.  Anything started after this is
+    // applied from the next frame so the bridge swap below always knows
+    // whether the frame will be modified.
+    bool effects = IsEffectRunning();
+    bool testing = ChannelTester::INSTANCE.Testing();
+    bool video = SDLOutput::IsOverlayingVideo();
+    const OverlaySnapshot *overlays = PixelOverlayManager::INSTANCE.acquireActiveSnapshot();
 
     if (m_bridgeData) {
-        // copy the latest bridge data to the sequence data
-        for (auto &a : GetOutputRanges()) {
-            memcpy(&m_seqData[a.first], &m_bridgeData[a.first], a.second);
-        }
+        std::unique_lock<std::mutex> lock(m_bridgeDirtyLock);
+        SwapBridgeBuffers(PluginManager::INSTANCE.hasPlugins() || effects || testing || video
+                          || overlays || PrepareChannelDataModifiesData());
+        freshBaseData = true;
+    }
+
+    // channels modified on top of the base data this frame
+    DirtyChannelRanges overlayRanges;
+    overlayRanges.clear();
+    if (PluginManager::INSTANCE.hasPlugins()) {
+        overlayRanges.setAllDirty();
     }
     PluginManager::INSTANCE.modifySequenceData(ms, (uint8_t*)m_seqData);
     
-    if (IsEffectRunning())
+    if (effects) {
+        overlayRanges.setAllDirty();
         OverlayEffects(m_seqData);
+    }
 
-    if (SDLOutput::IsOverlayingVideo()) {
+    if (video) {
         SDLOutput::ProcessVideoOverlay(ms);
     }
-    if (PixelOverlayManager::INSTANCE.hasActiveOverlays()) {
-        PixelOverlayManager::INSTANCE.doOverlays((uint8_t*)m_seqData);
-    }
+    PixelOverlayManager::INSTANCE.doOverlays(overlays, (uint8_t*)m_seqData, &overlayRanges);
 
     if (checkControlChannels && !m_dataProcessed && controlChannel)
     {
@@ -590,23 +706,90 @@ void Sequence::ProcessSequenceData(int ms, int checkControlChannels) {
         if (m_seqLastControlValue != thisValue) {
             m_seqLastControlValue = thisValue;
 
-            if (m_seqLastControlValue) {
+            if (!m_seqLastControlValue) {
+                // nothing to trigger
+            } else if (prepare) {
                 CommandManager::INSTANCE.TriggerPreset(m_seqLastControlValue);
+            } else {
+                // pipelined, commands are only run from the output thread
+                m_pendingPreset = m_seqLastControlValue;
             }
         }
     }
 
-    if (ChannelTester::INSTANCE.Testing())
+    if (testing) {
+        overlayRanges.setAllDirty();
         ChannelTester::INSTANCE.OverlayTestData(m_seqData);
+    }
     
     PluginManager::INSTANCE.modifyChannelData(ms, (uint8_t*)m_seqData);
-    
-    PrepareChannelData(m_seqData);
+
+    // anything overlaid last frame may have reverted to the base data
+    m_dirtyRanges.add(m_overlayRanges);
+    m_dirtyRanges.add(overlayRanges);
+    m_overlayRanges = overlayRanges;
+    m_prepareFreshBaseData = freshBaseData;
     m_dataProcessed = true;
+
+    if (prepare) {
+        PrepareSequenceData();
+    }
+}
+
+/*
+ * Let the outputs prepare the processed frame for sending.  Normally done
+ * by ProcessSequenceData, the pipelined output thread does it separately
+ * so the outputs never prepare one frame while sending the previous one.
+ */
+void Sequence::PrepareSequenceData(void) {
+    if (m_pendingPreset) {
+        unsigned char preset = m_pendingPreset;
+        m_pendingPreset = 0;
+        CommandManager::INSTANCE.TriggerPreset(preset);
+    }
+    PrepareChannelData(m_seqData, m_prepareFreshBaseData ? &m_dirtyRanges : nullptr);
+    m_dirtyRanges.clear();
+}
+
+void Sequence::MarkFrameDirty(FSEQFile::FrameData *data) {
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    if (data->frame == m_dirtyBaseFrame) {
+        // same frame data as before, nothing changed
+    } else if (m_dirtyBaseFrame >= 0 && data->frame == (m_dirtyBaseFrame + 1) && data->getDirtyRanges(ranges)) {
+        m_dirtyRanges.add(ranges);
+    } else {
+        m_dirtyRanges.setAllDirty();
+    }
+    m_dirtyBaseFrame = data->frame;
+    m_freshBaseData = true;
 }
 
 void Sequence::SendSequenceData(void) {
-    SendChannelData(m_seqData);
+    SendChannelData(m_outputData);
+}
+
+/*
+ * Normally the frame is read, processed and sent from the one buffer.
+ * When pipelined, the processed frame becomes the one to send and the
+ * next frame is read and processed into the other buffer while it's sent.
+ */
+void Sequence::SelectOutputBuffer(bool pipelined) {
+    if (!pipelined) {
+        m_outputData = m_seqData;
+        return;
+    }
+    char *second = GetSecondBuffer();
+    m_outputData = m_seqData;
+    m_seqData = (m_seqData == m_seqDataBuffer) ? second : m_seqDataBuffer;
+}
+
+char *Sequence::GetSecondBuffer() {
+    if (!m_secondBuffer) {
+        size_t size = (sizeof(m_seqDataBuffer) + __BIGGEST_ALIGNMENT__ - 1) & ~(size_t)(__BIGGEST_ALIGNMENT__ - 1);
+        m_secondBuffer = (char*)aligned_alloc(__BIGGEST_ALIGNMENT__, size);
+        memcpy(m_secondBuffer, m_seqDataBuffer, sizeof(m_seqDataBuffer));
+    }
+    return m_secondBuffer;
 }
 
 void Sequence::SendBlankingData(void) {
@@ -618,7 +801,7 @@ void Sequence::SendBlankingData(void) {
 
     BlankSequenceData();
     ProcessSequenceData(0, 0);
-    SendSequenceData();
+    SendChannelData(m_seqData);
 }
 
 void Sequence::CloseIfOpen(const std::string &filename) {
@@ -655,6 +838,7 @@ void Sequence::CloseSequenceFile(void) {
     
     m_seqFilename = "";
     m_seqPaused = 0;
+    m_dirtyBaseFrame = -1;
 
     if ((!IsEffectRunning()) &&
         ((getFPPmode() != REMOTE_MODE) &&
@@ -665,10 +849,87 @@ void Sequence::CloseSequenceFile(void) {
     
 }
 
+void Sequence::CopyChannelRanges(char *dst, const char *src, const DirtyChannelRanges &ranges) {
+    if (ranges.isAllDirty()) {
+        for (auto &a : GetOutputRanges()) {
+            memcpy(&dst[a.first], &src[a.first], a.second);
+        }
+    } else {
+        for (auto &a : ranges.getRanges()) {
+            memcpy(&dst[a.first], &src[a.first], a.second);
+        }
+    }
+}
+
+/*
+ * The bridge receives universes straight into the channel buffer that
+ * isn't live and the two are swapped each frame so the received data is
+ * output without being copied again.  Effects and overlays are applied
+ * in place to the live buffer.  Must be called with m_bridgeDirtyLock held.
+ */
+void Sequence::SwapBridgeBuffers(bool modifying) {
+    char *received = (char*)m_bridgeData;
+    char *previous = m_seqData;
+
+    // catch up on anything the received buffer missed the last time it
+    // was live, the previous frame is never modified if there is any
+    DirtyChannelRanges missed = m_bridgeStaleRanges;
+    missed.remove(m_bridgeDirtyRanges);
+    CopyChannelRanges(received, previous, missed);
+
+    m_seqData = received;
+    m_outputData = received;
+    m_bridgeData = (uint8_t*)previous;
+
+    // The previous frame is now the receive buffer and is missing what
+    // was just received.  If either frame is modified in place, it needs
+    // an unmodified copy now, otherwise it can wait until it's live again
+    // and most of it will likely have been received again by then.
+    // modifying must be sampled with the same state ProcessSequenceData
+    // then uses to modify the frame.
+    if (m_bridgeModified) {
+        DirtyChannelRanges all;
+        CopyChannelRanges(previous, received, all);
+        m_bridgeStaleRanges.clear();
+    } else if (modifying || m_bridgeDirtyRanges.isAllDirty()) {
+        CopyChannelRanges(previous, received, m_bridgeDirtyRanges);
+        m_bridgeStaleRanges.clear();
+    } else {
+        m_bridgeStaleRanges = m_bridgeDirtyRanges;
+    }
+    m_bridgeModified = modifying;
+
+    m_dirtyRanges.add(m_bridgeDirtyRanges);
+    m_dirtyRanges.add(missed);
+    m_bridgeDirtyRanges.clear();
+}
+
+void Sequence::GetSequenceStats(Json::Value &result) {
+    std::unique_lock<std::mutex> readLock(readFileLock);
+    if (m_seqFile) {
+        result["frame_pool_hits"] = (Json::UInt64)m_seqFile->getFramePoolHits();
+        result["frame_pool_misses"] = (Json::UInt64)m_seqFile->getFramePoolMisses();
+        result["blocks_decoded_ahead"] = (Json::UInt64)m_seqFile->getBlocksDecodedAhead();
+        result["decode_stalls"] = (Json::UInt64)m_seqFile->getDecodeStalls();
+        result["decoded_bytes_resident"] = (Json::UInt64)m_seqFile->getDecodedBytesResident();
+    }
+}
+
 void Sequence::SetBridgeData(uint8_t *data, int startChannel, int len) {
+    std::unique_lock<std::mutex> lock(m_bridgeDirtyLock);
     if (!m_bridgeData) {
-        m_bridgeData = (uint8_t*)calloc(1, FPPD_MAX_CHANNEL_NUM);
+        // receive into whichever channel buffer isn't live, it's swapped
+        // in by the next ProcessSequenceData
+        m_bridgeData = (uint8_t*)((m_seqData == m_seqDataBuffer) ? GetSecondBuffer() : m_seqDataBuffer);
+        for (auto &a : GetOutputRanges()) {
+            memset(&m_bridgeData[a.first], 0, a.second);
+        }
+        m_bridgeDirtyRanges.setAllDirty();
+        m_bridgeStaleRanges.clear();
+        m_bridgeModified = true;
     }
     memcpy(&m_bridgeData[startChannel], data, len);
+    m_bridgeDirtyRanges.add(startChannel, len);
+    lock.unlock();
     setDataNotProcessed();
 }
@@ -34,7 +34,10 @@
 #include <atomic>
 #include <condition_variable>
 
+#include <jsoncpp/json/json.h>
+
 #include "fseq/FSEQFile.h"
+#include "channeloutput/DirtyChannelRanges.h"
 
 
 #define FPPD_MAX_CHANNELS (8192*1024)
@@ -56,10 +59,12 @@ class Sequence {
 	int   OpenSequenceFile(const std::string &filename, int startFrame = 0, int startSecond = -1);
     void  StartSequence(const std::string &filename, int startFrame);
     void  StartSequence();
-	void  ProcessSequenceData(int ms, int checkControlChannels = 1);
+	void  ProcessSequenceData(int ms, int checkControlChannels = 1, bool prepare = true);
+	void  PrepareSequenceData(void);
 	void  SeekSequenceFile(int frameNumber);
-	void  ReadSequenceData(bool forceFirstFrame = false);
+	void  ReadSequenceData(bool forceFirstFrame = false, bool *deferred = nullptr);
 	void  SendSequenceData(void);
+	void  SelectOutputBuffer(bool pipelined);
 	void  SendBlankingData(void);
     void  CloseIfOpen(const std::string &filename);
 	void  CloseSequenceFile(void);
@@ -73,7 +78,8 @@ class Sequence {
 	int           m_seqMSDuration;
 	int           m_seqMSElapsed;
 	int           m_seqMSRemaining;
-	char          m_seqData[FPPD_MAX_CHANNEL_NUM] __attribute__ ((aligned (__BIGGEST_ALIGNMENT__)));
+	char         *m_seqData;     // frame being read and processed
+	char         *m_outputData;  // frame being sent, see SelectOutputBuffer
     std::string   m_seqFilename;
 
     
@@ -82,10 +88,44 @@ class Sequence {
     
     
     void SetBridgeData(uint8_t *data, int startChannel, int len);
+
+    void GetSequenceStats(Json::Value &result);
   private:
     void  SetLastFrameData(FSEQFile::FrameData *data);
-    
+    uint64_t GetReadAheadBudget(FSEQFile *seqFile);
+
+	char          m_seqDataBuffer[FPPD_MAX_CHANNEL_NUM] __attribute__ ((aligned (__BIGGEST_ALIGNMENT__)));
+    // second channel buffer for the pipelined output thread or the
+    // bridge, allocated the first time it's needed
+    char         *m_secondBuffer;
+    char         *GetSecondBuffer();
+    void  MarkFrameDirty(FSEQFile::FrameData *data);
+    void  SwapBridgeBuffers(bool modifying);
+    void  CopyChannelRanges(char *dst, const char *src, const DirtyChannelRanges &ranges);
+
+    // the channel buffer that isn't live, the bridge receives into it
     uint8_t      *m_bridgeData;
+    // channels m_bridgeData missed while it was live, caught up when it
+    // becomes live again unless received before then
+    DirtyChannelRanges m_bridgeStaleRanges;
+    // the live bridge frame may have been modified in place
+    bool          m_bridgeModified;
+
+    //output channels the open sequence doesn't provide, see ReadSequenceData
+    DirtyChannelRanges m_unreadRanges;
+    //control channel preset to trigger from PrepareSequenceData
+    unsigned char m_pendingPreset;
+
+    //channels changed since the last PrepareChannelData call
+    DirtyChannelRanges m_dirtyRanges;
+    //channels modified on top of the sequence data in the last frame
+    DirtyChannelRanges m_overlayRanges;
+    //universes received by the bridge since the last frame
+    DirtyChannelRanges m_bridgeDirtyRanges;
+    std::mutex    m_bridgeDirtyLock;
+    int           m_dirtyBaseFrame;
+    bool          m_freshBaseData;
+    bool          m_prepareFreshBaseData;
 
 	FSEQFile     *m_seqFile;
 
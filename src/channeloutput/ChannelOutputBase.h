@@ -44,6 +44,10 @@ class ChannelOutputBase {
     virtual int   Close(void);
     
     virtual void  PrepData(unsigned char *channelData) {}
+    // PrepData of different outputs may run at the same time on multiple
+    // cores.  Outputs that write to the channel data or share state with
+    // other outputs return true and are prepared in order before the rest.
+    virtual bool  PrepDataInSerial() { return false; }
 	virtual int   SendData(unsigned char *channelData) = 0;
 
 
@@ -0,0 +1,136 @@
+/*
+ *   Dirty channel range tracking for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fpp-pch.h"
+
+#include "DirtyChannelRanges.h"
+
+DirtyChannelRanges::DirtyChannelRanges()
+    : allDirty(true), generation(0), normalized(true)
+{
+}
+DirtyChannelRanges::~DirtyChannelRanges() {
+}
+
+void DirtyChannelRanges::clear() {
+    allDirty = false;
+    normalized = true;
+    ranges.clear();
+}
+void DirtyChannelRanges::setAllDirty() {
+    allDirty = true;
+    normalized = true;
+    ranges.clear();
+}
+void DirtyChannelRanges::add(uint32_t start, uint32_t count) {
+    if (allDirty || count == 0) {
+        return;
+    }
+    ranges.push_back(std::pair<uint32_t, uint32_t>(start, count));
+    normalized = false;
+}
+void DirtyChannelRanges::add(const std::vector<std::pair<uint32_t, uint32_t>> &r) {
+    if (allDirty) {
+        return;
+    }
+    ranges.insert(ranges.end(), r.begin(), r.end());
+    normalized = false;
+}
+void DirtyChannelRanges::add(const DirtyChannelRanges &r) {
+    if (r.allDirty) {
+        setAllDirty();
+    } else {
+        add(r.ranges);
+    }
+}
+
+void DirtyChannelRanges::remove(const DirtyChannelRanges &r) {
+    if (r.allDirty) {
+        clear();
+        return;
+    }
+    if (allDirty) {
+        return;
+    }
+    normalize();
+    r.normalize();
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    auto rit = r.ranges.begin();
+    for (auto &a : ranges) {
+        uint64_t start = a.first;
+        uint64_t end = (uint64_t)a.first + a.second;
+        while (rit != r.ranges.end() && ((uint64_t)rit->first + rit->second) <= start) {
+            rit++;
+        }
+        for (auto it = rit; it != r.ranges.end() && it->first < end; it++) {
+            if (it->first > start) {
+                result.push_back(std::pair<uint32_t, uint32_t>(start, it->first - start));
+            }
+            start = std::max(start, (uint64_t)it->first + it->second);
+        }
+        if (start < end) {
+            result.push_back(std::pair<uint32_t, uint32_t>(start, end - start));
+        }
+    }
+    ranges.swap(result);
+}
+
+const std::vector<std::pair<uint32_t, uint32_t>> &DirtyChannelRanges::getRanges() const {
+    normalize();
+    return ranges;
+}
+
+// sort the ranges and merge any that overlap or touch so isDirty
+// can binary search them
+void DirtyChannelRanges::normalize() const {
+    if (normalized) {
+        return;
+    }
+    std::sort(ranges.begin(), ranges.end());
+    int out = 0;
+    for (int x = 1; x < ranges.size(); x++) {
+        uint64_t end = (uint64_t)ranges[out].first + ranges[out].second;
+        if (ranges[x].first <= end) {
+            uint64_t newEnd = (uint64_t)ranges[x].first + ranges[x].second;
+            if (newEnd > end) {
+                ranges[out].second = newEnd - ranges[out].first;
+            }
+        } else {
+            ranges[++out] = ranges[x];
+        }
+    }
+    if (!ranges.empty()) {
+        ranges.resize(out + 1);
+    }
+    normalized = true;
+}
+
+bool DirtyChannelRanges::isDirty(uint32_t start, uint32_t count) const {
+    if (allDirty) {
+        return true;
+    }
+    normalize();
+    // find the first range that ends after start
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), start,
+                               [](uint32_t s, const std::pair<uint32_t, uint32_t> &r) {
+                                   return s < (uint64_t)r.first + r.second;
+                               });
+    return it != ranges.end() && it->first < (uint64_t)start + count;
+}
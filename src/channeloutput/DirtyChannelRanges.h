@@ -0,0 +1,63 @@
+#pragma once
+/*
+ *   Dirty channel range tracking for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <stdint.h>
+
+// The set of channel ranges that may have changed since the previous
+// frame was passed to the outputs.  Channels outside the set are
+// guaranteed to be the same as the previous frame.  If the changes are
+// not known, the entire set is marked dirty.
+class DirtyChannelRanges {
+public:
+    DirtyChannelRanges();
+    ~DirtyChannelRanges();
+
+    void clear();
+    void setAllDirty();
+    void add(uint32_t start, uint32_t count);
+    void add(const std::vector<std::pair<uint32_t, uint32_t>> &ranges);
+    void add(const DirtyChannelRanges &ranges);
+    // Removes the channels in ranges from the set.  An all dirty set stays
+    // all dirty as the full list of channels isn't known.
+    void remove(const DirtyChannelRanges &ranges);
+
+    bool isAllDirty() const { return allDirty; }
+    // isDirty and getRanges sort and merge the ranges the first time they
+    // are called after a change.  Call getRanges once before sharing the
+    // set between threads so the concurrent calls are read only.
+    bool isDirty(uint32_t start, uint32_t count) const;
+
+    // incremented each time PrepareChannelData is called so outputs can
+    // tell if they have seen every frame since they last saved their data
+    uint64_t getGeneration() const { return generation; }
+    void setGeneration(uint64_t g) { generation = g; }
+
+    const std::vector<std::pair<uint32_t, uint32_t>> &getRanges() const;
+
+private:
+    void normalize() const;
+
+    bool allDirty;
+    uint64_t generation;
+    mutable bool normalized;
+    mutable std::vector<std::pair<uint32_t, uint32_t>> ranges;
+};
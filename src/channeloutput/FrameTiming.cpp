@@ -0,0 +1,241 @@
+/*
+ *   Channel output frame timing statistics for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "fpp-pch.h"
+
+#include <algorithm>
+
+#include "FrameTiming.h"
+
+static const uint32_t BUCKET_LIMITS[FRAME_TIMING_BUCKETS - 1] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000
+};
+
+FrameTimingStats FrameTimingStats::INSTANCE;
+
+FrameTimingStats::FrameTimingStats()
+    : samples(FRAME_TIMING_SAMPLES), sampleCount(0), pendingBytes(0), outputCount(0) {
+    lateness.Reset();
+    for (auto &o : outputs) {
+        o.sendTime.Reset();
+        o.prepTime.Reset();
+    }
+}
+
+void FrameTimingStats::Histogram::Add(uint32_t us) {
+    int b = std::upper_bound(BUCKET_LIMITS, BUCKET_LIMITS + FRAME_TIMING_BUCKETS - 1, us) - BUCKET_LIMITS;
+    // each histogram has a single writer so relaxed load/store is enough for max
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(us, std::memory_order_relaxed);
+    if (us > max.load(std::memory_order_relaxed)) {
+        max.store(us, std::memory_order_relaxed);
+    }
+}
+void FrameTimingStats::Histogram::Reset() {
+    for (auto &b : buckets) {
+        b = 0;
+    }
+    count = 0;
+    total = 0;
+    max = 0;
+}
+Json::Value FrameTimingStats::Histogram::ToJson() const {
+    Json::Value result;
+    uint64_t c = count.load(std::memory_order_relaxed);
+    result["count"] = (Json::UInt64)c;
+    result["avg"] = c ? (Json::UInt64)(total.load(std::memory_order_relaxed) / c) : 0;
+    result["max"] = max.load(std::memory_order_relaxed);
+
+    Json::Value hist(Json::arrayValue);
+    for (int x = 0; x < FRAME_TIMING_BUCKETS; x++) {
+        Json::Value b;
+        if (x < (FRAME_TIMING_BUCKETS - 1)) {
+            b["le"] = BUCKET_LIMITS[x];
+        } else {
+            b["le"] = "inf";
+        }
+        b["count"] = buckets[x].load(std::memory_order_relaxed);
+        hist.append(b);
+    }
+    result["histogram"] = hist;
+    return result;
+}
+
+void FrameTimingStats::AddSample(FrameTimingSample &sample) {
+    sample.bytesSent = pendingBytes.exchange(0, std::memory_order_relaxed);
+    if (sample.lateness > 0) {
+        lateness.Add(sample.lateness);
+    } else {
+        lateness.Add(0);
+    }
+
+    std::unique_lock<std::mutex> lock(samplesLock);
+    samples[sampleCount % FRAME_TIMING_SAMPLES] = sample;
+    sampleCount++;
+}
+
+void FrameTimingStats::AddOutputSendTime(int output, int us, unsigned int channels) {
+    if (output < 0 || output >= FPPD_MAX_CHANNEL_OUTPUTS) {
+        return;
+    }
+    outputs[output].sendTime.Add(us < 0 ? 0 : us);
+    pendingBytes.fetch_add(channels, std::memory_order_relaxed);
+}
+
+void FrameTimingStats::AddOutputPrepTime(int output, int us) {
+    if (output < 0 || output >= FPPD_MAX_CHANNEL_OUTPUTS) {
+        return;
+    }
+    outputs[output].prepTime.Add(us < 0 ? 0 : us);
+}
+
+void FrameTimingStats::ClearOutputs() {
+    std::unique_lock<std::mutex> lock(samplesLock);
+    for (int x = 0; x < outputCount; x++) {
+        outputs[x].type.clear();
+        outputs[x].startChannel = 0;
+        outputs[x].channelCount = 0;
+        outputs[x].sendTime.Reset();
+        outputs[x].prepTime.Reset();
+    }
+    outputCount = 0;
+}
+
+void FrameTimingStats::SetOutputInfo(int output, const std::string &type,
+                                     unsigned int startChannel, unsigned int channelCount) {
+    if (output < 0 || output >= FPPD_MAX_CHANNEL_OUTPUTS) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(samplesLock);
+    outputs[output].type = type;
+    outputs[output].startChannel = startChannel;
+    outputs[output].channelCount = channelCount;
+    outputs[output].sendTime.Reset();
+    outputs[output].prepTime.Reset();
+    outputCount = std::max(outputCount, output + 1);
+}
+
+void FrameTimingStats::Reset() {
+    std::unique_lock<std::mutex> lock(samplesLock);
+    sampleCount = 0;
+    lateness.Reset();
+    for (int x = 0; x < outputCount; x++) {
+        outputs[x].sendTime.Reset();
+        outputs[x].prepTime.Reset();
+    }
+}
+
+Json::Value FrameTimingStats::GetOutputPrepTimes() {
+    Json::Value result(Json::arrayValue);
+    std::unique_lock<std::mutex> lock(samplesLock);
+    for (int x = 0; x < outputCount; x++) {
+        Json::Value o;
+        uint64_t c = outputs[x].prepTime.count.load(std::memory_order_relaxed);
+        o["index"] = x;
+        o["type"] = outputs[x].type;
+        o["avg"] = c ? (Json::UInt64)(outputs[x].prepTime.total.load(std::memory_order_relaxed) / c) : 0;
+        o["max"] = outputs[x].prepTime.max.load(std::memory_order_relaxed);
+        result.append(o);
+    }
+    return result;
+}
+
+template<class T>
+static Json::Value Percentiles(std::vector<T> &values) {
+    Json::Value result;
+    if (values.empty()) {
+        return result;
+    }
+    std::sort(values.begin(), values.end());
+    int64_t total = 0;
+    for (auto v : values) {
+        total += v;
+    }
+    size_t last = values.size() - 1;
+    result["min"] = (Json::Int64)values[0];
+    result["avg"] = (Json::Int64)(total / (int64_t)values.size());
+    result["p50"] = (Json::Int64)values[last * 50 / 100];
+    result["p90"] = (Json::Int64)values[last * 90 / 100];
+    result["p99"] = (Json::Int64)values[last * 99 / 100];
+    result["max"] = (Json::Int64)values[last];
+    return result;
+}
+
+Json::Value FrameTimingStats::GetStats() {
+    // copy what we need while holding the lock, the sorting is done after
+    // so the output thread is never held up by an API request
+    std::vector<FrameTimingSample> copy;
+    Json::Value outputStats(Json::arrayValue);
+    uint64_t total;
+    {
+        std::unique_lock<std::mutex> lock(samplesLock);
+        total = sampleCount;
+        size_t count = std::min(sampleCount, (uint64_t)FRAME_TIMING_SAMPLES);
+        copy.reserve(count);
+        for (uint64_t x = sampleCount - count; x < sampleCount; x++) {
+            copy.push_back(samples[x % FRAME_TIMING_SAMPLES]);
+        }
+        for (int x = 0; x < outputCount; x++) {
+            Json::Value o = outputs[x].sendTime.ToJson();
+            o["index"] = x;
+            o["type"] = outputs[x].type;
+            o["startChannel"] = outputs[x].startChannel + 1;
+            o["channelCount"] = outputs[x].channelCount;
+            o["prepTime"] = outputs[x].prepTime.ToJson();
+            outputStats.append(o);
+        }
+    }
+
+    Json::Value result;
+    result["frameCount"] = (Json::UInt64)total;
+    result["samples"] = (Json::UInt64)copy.size();
+    if (!copy.empty()) {
+        result["lightDelay"] = copy.back().lightDelay;
+        result["firstFrame"] = copy.front().frame;
+        result["lastFrame"] = copy.back().frame;
+    }
+
+    std::vector<int32_t> send, read, process, sleep, lateness, interval;
+    std::vector<uint32_t> bytes;
+    for (auto &s : copy) {
+        send.push_back(s.send);
+        read.push_back(s.read);
+        process.push_back(s.process);
+        sleep.push_back(s.sleep);
+        lateness.push_back(s.lateness);
+        if (s.interval) {
+            interval.push_back(s.interval);
+        }
+        bytes.push_back(s.bytesSent);
+    }
+    Json::Value frames;
+    frames["send"] = Percentiles(send);
+    frames["read"] = Percentiles(read);
+    frames["process"] = Percentiles(process);
+    frames["sleep"] = Percentiles(sleep);
+    frames["lateness"] = Percentiles(lateness);
+    frames["interval"] = Percentiles(interval);
+    frames["bytesSent"] = Percentiles(bytes);
+    result["frames"] = frames;
+
+    result["latenessHistogram"] = this->lateness.ToJson();
+    result["outputs"] = outputStats;
+    return result;
+}
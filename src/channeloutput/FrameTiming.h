@@ -0,0 +1,112 @@
+#pragma once
+/*
+ *   Channel output frame timing statistics for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <jsoncpp/json/json.h>
+
+#include "channeloutput.h"
+
+// Number of frames kept, about 100 seconds at 20fps
+#define FRAME_TIMING_SAMPLES 2048
+
+// Histogram bucket upper bounds in microseconds, the last bucket is
+// everything larger
+#define FRAME_TIMING_BUCKETS 13
+
+// Timings of one pass through the channel output thread, all times are
+// in microseconds
+class FrameTimingSample {
+public:
+    uint32_t frame = 0;
+    int32_t  lightDelay = 0; // frame interval the thread was aiming for
+    int32_t  send = 0;      // sending the previous frame to the outputs
+    int32_t  read = 0;      // reading the next frame from the fseq
+    int32_t  process = 0;   // effects, overlays, output processors, PrepData
+    int32_t  sleep = 0;     // planned sleep until the next frame
+    int32_t  lateness = 0;  // frame start vs when it should have started
+    int32_t  interval = 0;  // time since the previous frame started
+    uint32_t bytesSent = 0; // channels handed to the outputs
+};
+
+// Records the timing of the last FRAME_TIMING_SAMPLES frames of the
+// channel output thread and the time each output spends in PrepData and
+// SendData so they can be looked at without turning on debug logging.
+// Recording is cheap enough to always be on, the percentiles and
+// histograms are only calculated when the stats are requested.
+class FrameTimingStats {
+public:
+    static FrameTimingStats INSTANCE;
+
+    FrameTimingStats();
+
+    // called from the output thread, the channels sent by each output
+    // are added up into the bytesSent of the next sample
+    void AddSample(FrameTimingSample &sample);
+    void AddOutputSendTime(int output, int us, unsigned int channels);
+    // called from whichever thread prepared the output
+    void AddOutputPrepTime(int output, int us);
+
+    // called as the channel outputs are (re)initialized
+    void ClearOutputs();
+    void SetOutputInfo(int output, const std::string &type,
+                       unsigned int startChannel, unsigned int channelCount);
+
+    void Reset();
+    Json::Value GetStats();
+    // just the average/max PrepData time of each output, small enough
+    // to include in the fppd status
+    Json::Value GetOutputPrepTimes();
+
+private:
+    class Histogram {
+    public:
+        std::atomic<uint32_t> buckets[FRAME_TIMING_BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> total;
+        std::atomic<uint32_t> max;
+
+        void Add(uint32_t us);
+        void Reset();
+        Json::Value ToJson() const;
+    };
+    class OutputInfo {
+    public:
+        std::string type;
+        unsigned int startChannel = 0;
+        unsigned int channelCount = 0;
+        Histogram sendTime;
+        Histogram prepTime;
+    };
+
+    std::mutex samplesLock;
+    std::vector<FrameTimingSample> samples;
+    uint64_t sampleCount;
+    std::atomic<uint32_t> pendingBytes;
+
+    Histogram lateness;
+    int outputCount;
+    OutputInfo outputs[FPPD_MAX_CHANNEL_OUTPUTS];
+};
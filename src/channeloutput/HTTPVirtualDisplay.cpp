@@ -28,10 +28,39 @@
 #include <netinet/in.h>
 #include <fcntl.h>
 
-#include <iomanip>
+#include <climits>
 #include <ctime>
+#include <iomanip>
+#include <set>
 
 #include "HTTPVirtualDisplay.h"
+#include "util/ChannelDataCompare.h"
+
+/*
+ * Clients receive a single chunked HTTP response containing a stream of
+ * binary frames, one per changed sequence frame.  All values are little
+ * endian.  Each frame is:
+ *
+ *   uint32  number of changed pixels
+ *   then for each changed pixel:
+ *     uint16  x position in the preview
+ *     uint16  y position in the preview, measured from the top
+ *     uint8   red, green, blue
+ *
+ * Frames are not aligned with the HTTP chunks as seen by the browser so
+ * clients must use the count to find the end of each frame.
+ */
+#define HTTPVD_FRAME_HEADER_SIZE 4
+#define HTTPVD_PIXEL_SIZE        7
+
+// "%08x\r\n" chunk size prefix and the trailing "\r\n"
+#define HTTPVD_CHUNK_HEADER_SIZE 10
+#define HTTPVD_CHUNK_TRAILER_SIZE 2
+
+// A client is dropped once this many full frames are waiting to be sent
+// to it, a new client's first frame alone is often more than a fresh
+// socket's send buffer will take
+#define HTTPVD_MAX_BACKLOG_FRAMES 4
 
 
 extern "C" {
@@ -50,7 +79,10 @@ HTTPVirtualDisplayOutput::HTTPVirtualDisplayOutput(unsigned int startChannel,
   : VirtualDisplayOutput(startChannel, channelCount),
 	m_port(HTTPVIRTUALDISPLAYPORT),
 	m_screenSize(0),
+	m_firstChannel(0),
 	m_socket(-1),
+	m_snapshotId(0),
+	m_refreshSnapshot(true),
 	m_running(true),
 	m_connListChanged(true),
 	m_connThread(nullptr),
@@ -94,6 +126,9 @@ HTTPVirtualDisplayOutput::~HTTPVirtualDisplayOutput()
 			m_connList.erase(m_connList.begin() + i);
 		}
 	}
+
+	for (auto sub : m_subscriptions)
+		delete sub;
 }
 
 /*
@@ -141,6 +176,16 @@ int HTTPVirtualDisplayOutput::Init(Json::Value config)
 
 	bzero(m_virtualDisplay, m_screenSize);
 
+	GetRequiredChannelRanges([this](int min, int max) {
+		if (max >= min)
+		{
+			m_firstChannel = min;
+			m_lastChannelData.resize(max - min + 1);
+		}
+	});
+
+	m_snapshot.resize(m_pixels.size() * 3);
+
 	m_socket = socket(AF_INET, SOCK_STREAM, 0);
 	if (m_socket < 0)
 	{
@@ -205,37 +250,58 @@ void HTTPVirtualDisplayOutput::ConnectionThread(void)
 
 		if (client >= 0)
 		{
+			// Read the request line to find which view the client wants
+			struct timeval tv;
+			tv.tv_sec = 1;
+			tv.tv_usec = 0;
+			setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+			std::string request;
+			char buf[1024];
+			while (request.find("\r\n") == std::string::npos)
+			{
+				int bytesRead = recv(client, buf, sizeof(buf), 0);
+				if (bytesRead <= 0)
+					break;
+
+				request.append(buf, bytesRead);
+				if (request.size() > 8192)
+					break;
+			}
+
+			HTTPVirtualDisplaySubscription sub;
+			ParseSubscription(request, sub);
+
 			auto t = std::time(nullptr);
 			auto tm = *std::localtime(&t);
 			std::stringstream sstr;
 			sstr << std::put_time(&tm, "%a %b %d %H:%M:%S %Z %Y");
 
-			std::string sseResp;
-			sseResp =
+			std::string resp;
+			resp =
 				"HTTP/1.1 200 OK\r\n"
-				"Content-Type: text/event-stream;charset=UTF-8\r\n"
+				"Content-Type: application/octet-stream\r\n"
 				"Transfer-Encoding: chunked\r\n"
 				"Connection: close\r\n"
 				"Date: ";
-			sseResp += sstr.str();
-			sseResp +=
+			resp += sstr.str();
+			resp +=
 				"\r\n"
 				"Server: fppd\r\n"
                 "X-Powered-By: FPP/";
-            sseResp += getFPPVersion();
-            sseResp += "\r\n"
+            resp += getFPPVersion();
+            resp += "\r\n"
 				"Cache-Control: no-cache, private\r\n"
 				"Access-Control-Allow-Origin: *\r\n"
 				"Access-Control-Allow-Credentials: true\r\n"
 				"\r\n";
 
-			// Reset our display cache so we draw everything needed
-			bzero(m_virtualDisplay, m_screenSize);
-
 			std::unique_lock<std::mutex> lock(m_connListLock);
 			m_connList.push_back(client);
 
-			write(client, sseResp.c_str(), sseResp.length());
+			write(client, resp.c_str(), resp.length());
+
+			AddClient(client, sub);
 
 			m_connListChanged = true;
 		}
@@ -251,6 +317,7 @@ void HTTPVirtualDisplayOutput::SelectThread(void)
 {
 	fd_set active_fd_set;
 	fd_set read_fd_set;
+	fd_set write_fd_set;
 	int    selectResult;
 	struct timeval timeout;
 	char   buf[1024];
@@ -275,12 +342,23 @@ void HTTPVirtualDisplayOutput::SelectThread(void)
 			m_connListChanged = 0;
 		}
 
-		timeout.tv_sec = 1;
-		timeout.tv_usec = 0;
-
 		read_fd_set = active_fd_set;
 
-		selectResult = select(FD_SETSIZE, &read_fd_set, NULL, NULL, &timeout);
+		FD_ZERO(&write_fd_set);
+		{
+			std::unique_lock<std::mutex> lock(m_connListLock);
+			for (auto &b : m_backlogs)
+			{
+				FD_SET(b.first, &write_fd_set);
+			}
+		}
+
+		// Backlogs may be added by SendData while we're waiting, so
+		// don't wait too long before checking for them again
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 100000;
+
+		selectResult = select(FD_SETSIZE, &read_fd_set, &write_fd_set, NULL, &timeout);
 		if (selectResult < 0)
 		{
 			if (errno == EINTR)
@@ -290,6 +368,8 @@ void HTTPVirtualDisplayOutput::SelectThread(void)
 			else
 			{
 				LogErr(VB_CHANNELOUT, "Main select() failed\n");
+				m_connListChanged = true;
+				continue;
 			}
 		}
 		else if (selectResult == 0)
@@ -313,146 +393,355 @@ void HTTPVirtualDisplayOutput::SelectThread(void)
 				{
 					LogDebug(VB_CHANNELOUT, "Closing socket %d, connection %d\n", m_connList[i], i);
 					close(m_connList[i]);
-					m_connList.erase(m_connList.begin() + i);
-					m_connListChanged = true;
+					RemoveClient(m_connList[i]);
 				}
 				else
 				{
 					LogErr(VB_CHANNELOUT, "Read failed for socket %d, connection %d.  Closing connection.\n", m_connList[i], i);
-					m_connList.erase(m_connList.begin() + i);
-					m_connListChanged = true;
+					close(m_connList[i]);
+					RemoveClient(m_connList[i]);
 				}
 			}
+			else if (FD_ISSET(m_connList[i], &write_fd_set) && !FlushBacklog(m_connList[i]))
+			{
+				LogWarn(VB_CHANNELOUT, "Send failed for socket %d, closing connection: %s\n",
+					m_connList[i], strerror(errno));
+				close(m_connList[i]);
+				RemoveClient(m_connList[i]);
+			}
 		}
 	}
 }
 
 /*
- *
+ * Parse the requested view from the query string of the request line
  */
-int HTTPVirtualDisplayOutput::WriteSSEPacket(int fd, std::string data)
+void HTTPVirtualDisplayOutput::ParseSubscription(const std::string &request,
+	HTTPVirtualDisplaySubscription &sub)
 {
-	int len = data.size();
-	std::stringstream stream;
-	std::string sendData;
+	std::string line = request.substr(0, request.find("\r\n"));
+	std::vector<std::string> parts = split(line, ' ');
+	if (parts.size() < 2)
+		return;
 
-	stream << std::hex << len;
-	sendData = stream.str();
-	sendData += "\r\n";
-	sendData += data + "\r\n";
+	size_t q = parts[1].find('?');
+	if (q == std::string::npos)
+		return;
 
-	write(fd, sendData.c_str(), sendData.size());
+	for (auto &param : split(parts[1].substr(q + 1), '&'))
+	{
+		size_t eq = param.find('=');
+		if (eq == std::string::npos)
+			continue;
 
-	return 1;
+		std::string key = param.substr(0, eq);
+		int value = atoi(param.substr(eq + 1).c_str());
+		if (value < 0)
+			value = 0;
+
+		if (key == "fps")
+			sub.fps = value;
+		else if (key == "x")
+			sub.x = value;
+		else if (key == "y")
+			sub.y = value;
+		else if (key == "w")
+			sub.width = value;
+		else if (key == "h")
+			sub.height = value;
+		else if ((key == "scale") && value)
+			sub.scale = value;
+	}
+}
+
+/*
+ * Add a client to the subscription for its view, creating the
+ * subscription if nobody else is watching that view.  m_connListLock
+ * must be held.
+ */
+void HTTPVirtualDisplayOutput::AddClient(int fd, HTTPVirtualDisplaySubscription &request)
+{
+	HTTPVirtualDisplaySubscription *sub = nullptr;
+	for (auto s : m_subscriptions)
+	{
+		if (s->SameView(request))
+		{
+			sub = s;
+			break;
+		}
+	}
+
+	if (!sub)
+	{
+		sub = new HTTPVirtualDisplaySubscription(request);
+
+		int right = sub->width ? sub->x + sub->width : INT_MAX;
+		int bottom = sub->height ? sub->y + sub->height : INT_MAX;
+		std::set<std::pair<int, int>> blocks;
+
+		for (int i = 0; i < m_pixels.size(); i++)
+		{
+			int px = m_pixels[i].x;
+			int py = m_previewHeight - m_pixels[i].y;
+
+			if ((px < sub->x) || (px >= right) || (py < sub->y) || (py >= bottom))
+				continue;
+
+			if ((sub->scale > 1) &&
+				!blocks.insert(std::make_pair(px / sub->scale, py / sub->scale)).second)
+				continue;
+
+			sub->pixels.push_back(i);
+		}
+
+		sub->lastColors.resize(sub->pixels.size() * 3);
+		sub->frameData.resize(HTTPVD_CHUNK_HEADER_SIZE + HTTPVD_FRAME_HEADER_SIZE +
+			(sub->pixels.size() * HTTPVD_PIXEL_SIZE) + HTTPVD_CHUNK_TRAILER_SIZE);
+
+		m_subscriptions.push_back(sub);
+
+		LogDebug(VB_CHANNELOUT, "New subscription with %d of %d pixels at %d fps\n",
+			(int)sub->pixels.size(), (int)m_pixels.size(), sub->fps);
+	}
+
+	sub->clients.push_back(fd);
+
+	// Send every pixel so the new client starts with the full display
+	sub->sendFullFrame = true;
+	m_refreshSnapshot = true;
+}
+
+/*
+ * Forget about a client which has already been closed, m_connListLock
+ * must be held.
+ */
+void HTTPVirtualDisplayOutput::RemoveClient(int fd)
+{
+	m_connList.erase(std::remove(m_connList.begin(), m_connList.end(), fd), m_connList.end());
+	m_backlogs.erase(fd);
+	m_connListChanged = true;
+
+	for (int i = m_subscriptions.size() - 1; i >= 0; i--)
+	{
+		HTTPVirtualDisplaySubscription *sub = m_subscriptions[i];
+		sub->clients.erase(std::remove(sub->clients.begin(), sub->clients.end(), fd),
+			sub->clients.end());
+
+		if (sub->clients.empty())
+		{
+			delete sub;
+			m_subscriptions.erase(m_subscriptions.begin() + i);
+		}
+	}
 }
 
 /*
  *
  */
-void HTTPVirtualDisplayOutput::PrepData(unsigned char *channelData)
+static inline void PutUInt16(unsigned char *p, uint16_t v)
 {
-	static int id = 0;
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
 
-	LogExcess(VB_CHANNELOUT, "HTTPVirtualDisplayOutput::PrepData(%p)\n",
-		channelData);
+/*
+ * Encode the pixels of the subscription's view which changed since its
+ * last frame, leaving frameSize at 0 if there is nothing to send yet.
+ */
+void HTTPVirtualDisplayOutput::EncodeFrame(HTTPVirtualDisplaySubscription *sub)
+{
+	sub->frameSize = 0;
+
+	// Nothing to send for a region without any pixels
+	if (sub->pixels.empty())
+		return;
+
+	if (!sub->sendFullFrame && (sub->snapshotId == m_snapshotId))
+		return;
 
+	if (sub->fps)
 	{
-		// Short circuit if no current connections
-		std::unique_lock<std::mutex> lock(m_connListLock);
-		if (!m_connList.size())
+		// Keep to the requested rate on average rather than drifting
+		// later by up to a frame every time
+		long long now = GetTimeMS();
+		if (now < sub->nextFrameMS)
 			return;
+
+		long long interval = 1000 / sub->fps;
+		sub->nextFrameMS += interval;
+		if (sub->nextFrameMS <= now)
+			sub->nextFrameMS = now + interval;
 	}
 
-	std::string data;
-	int pixelsChanged = 0;
-	unsigned char r, g, b;
-	std::map<std::string, std::string> colors;
-	std::map<std::string, std::string>::iterator colorIt;
-	char color[4];
-	std::string colorStr;
-	char loc[7];
-	int y;
-	VirtualDisplayPixel pixel;
-	char base64[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz+/";
-
-//	if ((id % 2) == 0)
-//	{
-//		id++;
-//
-//		return m_channelCount;
-//	}
-
-	for (int i = 0; i < m_pixels.size(); i++)
-	{
-		GetPixelRGB(m_pixels[i], channelData, r, g, b);
+	bool fullFrame = sub->sendFullFrame;
+	sub->sendFullFrame = false;
+	sub->snapshotId = m_snapshotId;
 
-		// 18-bit RGB666 pixel data passed over Event Stream in 3 bytes
-		// using Base64 allowed characters since SSE is non-binary
-		r = r >> 2;
-		g = g >> 2;
-		b = b >> 2;
+	unsigned char *frame = &sub->frameData[HTTPVD_CHUNK_HEADER_SIZE];
+	unsigned char *p = frame + HTTPVD_FRAME_HEADER_SIZE;
+	unsigned char *last = sub->lastColors.data();
+	uint32_t pixelsChanged = 0;
+
+	for (auto i : sub->pixels)
+	{
+		const unsigned char *rgb = &m_snapshot[i * 3];
 
-		if ((m_virtualDisplay[m_pixels[i].r] != r) ||
-			(m_virtualDisplay[m_pixels[i].g] != g) ||
-			(m_virtualDisplay[m_pixels[i].b] != b))
+		if (fullFrame || (last[0] != rgb[0]) || (last[1] != rgb[1]) || (last[2] != rgb[2]))
 		{
-			m_virtualDisplay[m_pixels[i].r] = r;
-			m_virtualDisplay[m_pixels[i].g] = g;
-			m_virtualDisplay[m_pixels[i].b] = b;
-
-			sprintf(color, "%c%c%c", base64[r], base64[g], base64[b]);
-			colorStr = color;
-
-			y = m_previewHeight - m_pixels[i].y;
-			if (m_pixels[i].x >= 4095)
-				sprintf(loc, "%c%c%c%c%c%c",
-					base64[(m_pixels[i].x >> 12) & 0x3f], 
-					base64[(m_pixels[i].x >> 6) & 0x3f], 
-					base64[(m_pixels[i].x) & 0x3f],
-					base64[(y >> 12) & 0x3f], 
-					base64[(y >> 6) & 0x3f], 
-					base64[(y) & 0x3f]);
-			else
-				sprintf(loc, "%c%c%c%c",
-					base64[(m_pixels[i].x >> 6) & 0x3f], 
-					base64[(m_pixels[i].x) & 0x3f],
-					base64[(y >> 6) & 0x3f], 
-					base64[(y) & 0x3f]);
-
-			colorIt = colors.find(colorStr);
-			if (colorIt != colors.end())
-				colorIt->second += std::string(";") + loc;
-			else
-				colors[colorStr] = colorStr + ":" + loc;
+			last[0] = rgb[0];
+			last[1] = rgb[1];
+			last[2] = rgb[2];
+
+			PutUInt16(p, m_pixels[i].x);
+			PutUInt16(p + 2, m_previewHeight - m_pixels[i].y);
+			p[4] = rgb[0];
+			p[5] = rgb[1];
+			p[6] = rgb[2];
+			p += HTTPVD_PIXEL_SIZE;
 
 			pixelsChanged++;
 		}
+		last += 3;
 	}
 
-	if (colors.size())
+	if (!pixelsChanged)
+		return;
+
+	frame[0] = pixelsChanged & 0xFF;
+	frame[1] = (pixelsChanged >> 8) & 0xFF;
+	frame[2] = (pixelsChanged >> 16) & 0xFF;
+	frame[3] = pixelsChanged >> 24;
+
+	int len = p - frame;
+	char chunkHeader[HTTPVD_CHUNK_HEADER_SIZE + 1];
+	snprintf(chunkHeader, sizeof(chunkHeader), "%08x\r\n", len);
+	memcpy(&sub->frameData[0], chunkHeader, HTTPVD_CHUNK_HEADER_SIZE);
+	p[0] = '\r';
+	p[1] = '\n';
+
+	sub->frameSize = HTTPVD_CHUNK_HEADER_SIZE + len + HTTPVD_CHUNK_TRAILER_SIZE;
+
+	LogExcess(VB_CHANNELOUT, "PixelsChanged: %d of %d, Data Size: %d\n",
+		pixelsChanged, (int)sub->pixels.size(), sub->frameSize);
+}
+
+/*
+ *
+ */
+void HTTPVirtualDisplayOutput::PrepData(unsigned char *channelData)
+{
+	LogExcess(VB_CHANNELOUT, "HTTPVirtualDisplayOutput::PrepData(%p)\n",
+		channelData);
+
+	std::unique_lock<std::mutex> lock(m_connListLock);
+
+	// Short circuit if no current connections
+	if (m_subscriptions.empty())
+		return;
+
+	bool refresh = m_refreshSnapshot.exchange(false);
+	if (refresh)
+	{
+		if (m_lastChannelData.size())
+			memcpy(&m_lastChannelData[0], channelData + m_firstChannel,
+				m_lastChannelData.size());
+	}
+	else if (m_lastChannelData.size() &&
+		!ChannelDataCopyIfDifferent(&m_lastChannelData[0],
+			channelData + m_firstChannel, m_lastChannelData.size()))
 	{
-		m_sseData = "id: ";
-		m_sseData += std::to_string(id) + "\r\n";
-		m_sseData += "event: message\r\n";
-		m_sseData += "data: ";
+		// None of the display's channels changed so the snapshot is
+		// still current, but decimated subscriptions may be due to send
+		// changes they skipped earlier
+		for (auto sub : m_subscriptions)
+			EncodeFrame(sub);
 
-		std::string data2;
-		for (const auto &pair : colors)
-		{
-			if (data2 != "")
-				data2 += "|";
+		return;
+	}
+
+	unsigned char *rgb = m_snapshot.data();
+	for (auto &pixel : m_pixels)
+	{
+		GetPixelRGB(pixel, channelData, rgb[0], rgb[1], rgb[2]);
+		rgb += 3;
+	}
+	m_snapshotId++;
+
+	for (auto sub : m_subscriptions)
+		EncodeFrame(sub);
+}
+
+/*
+ * Send the subscription's current frame to a client without ever blocking
+ * the output thread.  Whatever the socket won't take is kept in the
+ * client's backlog and sent as the socket becomes writable.  Returns false
+ * if the client should be dropped because the send failed or it has
+ * fallen too far behind.  m_connListLock must be held.
+ */
+bool HTTPVirtualDisplayOutput::QueueFrame(int fd, const HTTPVirtualDisplaySubscription *sub)
+{
+	const unsigned char *data = &sub->frameData[0];
+	int len = sub->frameSize;
 
-			data2 += pair.second;
+	auto it = m_backlogs.find(fd);
+	if (it == m_backlogs.end())
+	{
+		ssize_t sent = send(fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+			{
+				LogWarn(VB_CHANNELOUT, "Could not send frame to socket %d, closing connection: %s\n",
+					fd, strerror(errno));
+				return false;
+			}
+			sent = 0;
 		}
-		m_sseData += data2 + "\r\n\r\n";
+		if (sent == len)
+			return true;
 
-		LogExcess(VB_CHANNELOUT, "PixelsChanged: %d, Colors: %d, Data Size: %d\n",
-			pixelsChanged, colors.size(), m_sseData.size());
+		m_backlogs[fd].assign(data + sent, data + len);
+		return true;
 	}
+
+	std::vector<unsigned char> &backlog = it->second;
+	if ((backlog.size() + len) > (HTTPVD_MAX_BACKLOG_FRAMES * sub->frameData.size()))
+	{
+		LogWarn(VB_CHANNELOUT, "Socket %d is too far behind, closing connection\n", fd);
+		return false;
+	}
+	backlog.insert(backlog.end(), data, data + len);
+
+	if (!FlushBacklog(fd))
+	{
+		LogWarn(VB_CHANNELOUT, "Could not send frame to socket %d, closing connection: %s\n",
+			fd, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Send as much of the client's backlog as the socket will take, returns
+ * false if the send failed.  m_connListLock must be held.
+ */
+bool HTTPVirtualDisplayOutput::FlushBacklog(int fd)
+{
+	auto it = m_backlogs.find(fd);
+	if (it == m_backlogs.end())
+		return true;
+
+	std::vector<unsigned char> &backlog = it->second;
+	ssize_t sent = send(fd, &backlog[0], backlog.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (sent < 0)
+		return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+
+	if (sent == backlog.size())
+		m_backlogs.erase(it);
 	else
-		m_sseData = "";
+		backlog.erase(backlog.begin(), backlog.begin() + sent);
 
-	id++;
+	return true;
 }
 
 /*
@@ -460,13 +749,26 @@ void HTTPVirtualDisplayOutput::PrepData(unsigned char *channelData)
  */
 int HTTPVirtualDisplayOutput::SendData(unsigned char *channelData)
 {
-	if (m_sseData != "")
+	std::unique_lock<std::mutex> lock(m_connListLock);
+	std::vector<int> failed;
+
+	for (auto sub : m_subscriptions)
 	{
-		std::unique_lock<std::mutex> lock(m_connListLock);
-		for (int i = 0; i < m_connList.size(); i++)
-			WriteSSEPacket(m_connList[i], m_sseData);
+		if (!sub->frameSize)
+			continue;
+
+		for (auto fd : sub->clients)
+		{
+			if (!QueueFrame(fd, sub))
+				failed.push_back(fd);
+		}
+	}
+
+	for (auto fd : failed)
+	{
+		close(fd);
+		RemoveClient(fd);
 	}
 
 	return m_channelCount;
 }
-
@@ -24,6 +24,8 @@
  *   along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
+#include <map>
 #include <thread>
 #include <vector>
 #include <mutex>
@@ -32,6 +34,38 @@
 
 #define HTTPVIRTUALDISPLAYPORT 32328
 
+// A view of the display requested by one or more clients.  Clients asking
+// for the same view share the subscription and the frames encoded for it.
+class HTTPVirtualDisplaySubscription {
+  public:
+	// Requested via the query string, ie. /?fps=10&x=0&y=0&w=200&h=100&scale=2
+	int  fps = 0;      // 0 sends every changed frame
+	int  x = 0;        // region of interest in preview coordinates, y is
+	int  y = 0;        // measured from the top, a width or height of 0
+	int  width = 0;    // extends to the edge of the preview
+	int  height = 0;
+	int  scale = 1;    // only send one pixel per scale x scale block
+
+	// Indexes into m_pixels of the pixels in this view and their colors
+	// as last sent to the clients
+	std::vector<int> pixels;
+	std::vector<unsigned char> lastColors;
+
+	long long nextFrameMS = 0;
+	int  snapshotId = -1;
+	bool sendFullFrame = true;
+
+	std::vector<unsigned char> frameData;
+	int  frameSize = 0;
+
+	std::vector<int> clients;
+
+	bool SameView(const HTTPVirtualDisplaySubscription &s) const {
+		return (fps == s.fps) && (x == s.x) && (y == s.y) && (width == s.width) &&
+			(height == s.height) && (scale == s.scale);
+	}
+};
+
 class HTTPVirtualDisplayOutput : protected VirtualDisplayOutput {
   public:
 	HTTPVirtualDisplayOutput(unsigned int startChannel, unsigned int channelCount);
@@ -47,14 +81,32 @@ class HTTPVirtualDisplayOutput : protected VirtualDisplayOutput {
 	void SelectThread(void);
 
   private:
-	int  WriteSSEPacket(int fd, std::string data);
+	void ParseSubscription(const std::string &request, HTTPVirtualDisplaySubscription &sub);
+	void AddClient(int fd, HTTPVirtualDisplaySubscription &sub);
+	void RemoveClient(int fd);
+	void EncodeFrame(HTTPVirtualDisplaySubscription *sub);
+	bool QueueFrame(int fd, const HTTPVirtualDisplaySubscription *sub);
+	bool FlushBacklog(int fd);
 
 	int  m_port;
 	int  m_screenSize;
 
+	// Copy of the channels used by the display as of the last PrepData()
+	int  m_firstChannel;
+	std::vector<unsigned char> m_lastChannelData;
+
 	int m_socket;
 
-	std::string m_sseData;
+	// RGB of every pixel in m_pixels as of the last PrepData().  All the
+	// subscriptions' frames are encoded from this one copy.
+	std::vector<unsigned char> m_snapshot;
+	int  m_snapshotId;
+
+	// Set when a client connects since the snapshot isn't kept up to
+	// date while nobody is watching
+	std::atomic_bool m_refreshSnapshot;
+
+	std::vector<HTTPVirtualDisplaySubscription *> m_subscriptions;
 
 	volatile bool m_running;
 	volatile bool m_connListChanged;
@@ -63,4 +115,9 @@ class HTTPVirtualDisplayOutput : protected VirtualDisplayOutput {
 
 	std::mutex m_connListLock;
 	std::vector<int> m_connList;
+
+	// Data the clients' sockets could not take yet, always ending on a
+	// frame boundary.  Flushed by the select thread as the sockets
+	// become writable.
+	std::map<int, std::vector<unsigned char>> m_backlogs;
 };
@@ -0,0 +1,200 @@
+/*
+ *   MultiSync master clock tracking for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "fpp-pch.h"
+
+#include <climits>
+#include <cmath>
+
+#include "MasterFrameClock.h"
+
+// anything more is a bad estimate, crystals are good to ~100ppm
+#define MAX_DRIFT 0.0005
+
+MasterFrameClock MasterFrameClock::INSTANCE;
+
+MasterFrameClock::MasterFrameClock() {
+    Reset();
+}
+
+void MasterFrameClock::Reset() {
+    std::unique_lock<std::mutex> l(lock);
+    offsetCount = 0;
+    offsetPos = 0;
+    blockSamples = 0;
+    blockCount = 0;
+    blockPos = 0;
+    envelopeTime = 0;
+    envelopeOffset = 0;
+    drift = 0.0;
+    jitter = 0.0;
+
+    frameCount = 0;
+    framePos = 0;
+    framePeriod = 0.0;
+
+    phaseError = 0;
+    avgPhaseError = 0.0;
+    maxPhaseError = 0;
+}
+
+void MasterFrameClock::ResetFrames() {
+    std::unique_lock<std::mutex> l(lock);
+    frameCount = 0;
+    framePos = 0;
+    framePeriod = 0.0;
+}
+
+void MasterFrameClock::AddSyncPoint(uint32_t frame, long long masterTime, long long localTime) {
+    std::unique_lock<std::mutex> l(lock);
+
+    long long offset = masterTime - localTime;
+    if (offsetCount) {
+        // interarrival jitter as in RFC 3550
+        const OffsetSample &prev = offsets[(offsetPos + MASTER_CLOCK_OFFSET_SAMPLES - 1) % MASTER_CLOCK_OFFSET_SAMPLES];
+        double d = std::fabs((offset - prev.offset) - drift * (localTime - prev.localTime));
+        jitter += (d - jitter) / 16.0;
+    }
+    offsets[offsetPos].localTime = localTime;
+    offsets[offsetPos].offset = offset;
+    offsetPos = (offsetPos + 1) % MASTER_CLOCK_OFFSET_SAMPLES;
+    if (offsetCount < MASTER_CLOCK_OFFSET_SAMPLES) {
+        offsetCount++;
+    }
+
+    // Network delay only ever makes a packet late, so the packets with the
+    // largest offset were the least delayed.  Drift is the slope of a least
+    // squares fit of the best packet from each block, once they cover
+    // enough time.
+    if (!blockSamples || offset > blockBest.offset) {
+        blockBest.localTime = localTime;
+        blockBest.offset = offset;
+    }
+    if (++blockSamples == MASTER_CLOCK_OFFSET_SAMPLES) {
+        blocks[blockPos] = blockBest;
+        blockPos = (blockPos + 1) % MASTER_CLOCK_DRIFT_BLOCKS;
+        if (blockCount < MASTER_CLOCK_DRIFT_BLOCKS) {
+            blockCount++;
+        }
+        blockSamples = 0;
+
+        const OffsetSample &oldest = blocks[(blockPos + MASTER_CLOCK_DRIFT_BLOCKS - blockCount) % MASTER_CLOCK_DRIFT_BLOCKS];
+        if (blockCount >= 3 && (localTime - oldest.localTime) > 10000000) {
+            double sx = 0, sy = 0, sxx = 0, sxy = 0;
+            for (int x = 0; x < blockCount; x++) {
+                double dx = (blocks[x].localTime - localTime) / 1000000.0;
+                double dy = blocks[x].offset - offset;
+                sx += dx;
+                sy += dy;
+                sxx += dx * dx;
+                sxy += dx * dy;
+            }
+            double denom = blockCount * sxx - sx * sx;
+            if (denom > 0) {
+                // us per second is ppm
+                drift = (blockCount * sxy - sx * sy) / denom / 1000000.0;
+                drift = std::max(-MAX_DRIFT, std::min(MAX_DRIFT, drift));
+            }
+        }
+    }
+
+    envelopeTime = localTime;
+    envelopeOffset = LLONG_MIN;
+    for (int x = 0; x < offsetCount; x++) {
+        long long o = offsets[x].offset + (long long)(drift * (localTime - offsets[x].localTime));
+        envelopeOffset = std::max(envelopeOffset, o);
+    }
+
+    if (frameCount) {
+        const FrameSample &last = frames[(framePos + MASTER_CLOCK_FRAME_SAMPLES - 1) % MASTER_CLOCK_FRAME_SAMPLES];
+        bool restart = frame <= last.frame;
+        if (!restart && framePeriod > 0) {
+            // the master seeked, start over from here
+            double expected = last.masterTime + (frame - last.frame) * framePeriod;
+            restart = std::fabs(masterTime - expected) > 1000000;
+        }
+        if (restart) {
+            LogDebug(VB_SYNC, "Master frame timeline restarted at frame %d\n", frame);
+            frameCount = 0;
+            framePos = 0;
+            framePeriod = 0.0;
+        }
+    }
+    frames[framePos].frame = frame;
+    frames[framePos].masterTime = masterTime;
+    framePos = (framePos + 1) % MASTER_CLOCK_FRAME_SAMPLES;
+    if (frameCount < MASTER_CLOCK_FRAME_SAMPLES) {
+        frameCount++;
+    }
+    if (frameCount >= 2) {
+        const FrameSample &first = frames[(framePos + MASTER_CLOCK_FRAME_SAMPLES - frameCount) % MASTER_CLOCK_FRAME_SAMPLES];
+        framePeriod = (double)(masterTime - first.masterTime) / (frame - first.frame);
+    }
+
+    LogExcess(VB_SYNC, "Master clock: frame %d, offset %lld, drift %.1fppm, jitter %.0fus, period %.0fus\n",
+              frame, envelopeOffset, drift * 1000000.0, jitter, framePeriod);
+}
+
+bool MasterFrameClock::isLocked(long long now) {
+    if (frameCount < 3 || offsetCount < 3 || framePeriod <= 0) {
+        return false;
+    }
+    // no sync packets for a while, the master is gone or has stopped
+    const OffsetSample &newest = offsets[(offsetPos + MASTER_CLOCK_OFFSET_SAMPLES - 1) % MASTER_CLOCK_OFFSET_SAMPLES];
+    return (now - newest.localTime) < 3000000;
+}
+
+long long MasterFrameClock::offsetAt(long long localTime) {
+    return envelopeOffset + (long long)(drift * (localTime - envelopeTime));
+}
+
+bool MasterFrameClock::GetFrameTime(uint32_t frame, long long now, long long &localTime) {
+    std::unique_lock<std::mutex> l(lock);
+    if (!isLocked(now)) {
+        return false;
+    }
+    const FrameSample &last = frames[(framePos + MASTER_CLOCK_FRAME_SAMPLES - 1) % MASTER_CLOCK_FRAME_SAMPLES];
+    double masterTime = last.masterTime + ((double)frame - (double)last.frame) * framePeriod;
+    localTime = (long long)masterTime - offsetAt(now);
+    return true;
+}
+
+int MasterFrameClock::GetFramePeriod() {
+    std::unique_lock<std::mutex> l(lock);
+    return framePeriod / (1.0 + drift);
+}
+
+void MasterFrameClock::AddPhaseError(int us) {
+    std::unique_lock<std::mutex> l(lock);
+    phaseError = us;
+    avgPhaseError += (std::abs(us) - avgPhaseError) / 16.0;
+    maxPhaseError = std::max(maxPhaseError, std::abs(us));
+}
+
+void MasterFrameClock::GetStats(MasterClockStats &stats) {
+    std::unique_lock<std::mutex> l(lock);
+    stats.locked = isLocked(GetMonotonicTime());
+    stats.offset = offsetCount ? envelopeOffset : 0;
+    stats.driftPPM = drift * 1000000.0;
+    stats.jitter = jitter;
+    stats.framePeriod = framePeriod / (1.0 + drift);
+    stats.phaseError = phaseError;
+    stats.avgPhaseError = avgPhaseError;
+    stats.maxPhaseError = maxPhaseError;
+}
@@ -0,0 +1,116 @@
+#pragma once
+/*
+ *   MultiSync master clock tracking for Falcon Player (FPP)
+ *
+ *   Copyright (C) 2013-2018 the Falcon Player Developers
+ *      For additional credits and developers, see credits.php.
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+#include <stdint.h>
+
+// The offset is taken from the last 16 sync packets (about 8 seconds),
+// the drift from the least delayed packet of each of the last 16 blocks
+// of packets so it has a couple of minutes to average over
+#define MASTER_CLOCK_OFFSET_SAMPLES 16
+#define MASTER_CLOCK_DRIFT_BLOCKS 16
+#define MASTER_CLOCK_FRAME_SAMPLES 16
+
+class MasterClockStats {
+public:
+    bool      locked = false;
+    long long offset = 0;      // master clock - local clock, us
+    double    driftPPM = 0.0;  // how much faster the master clock runs
+    int       jitter = 0;      // smoothed packet delay variation, us
+    int       framePeriod = 0; // master frame period on the local clock, us
+    int       phaseError = 0;  // last frame start vs the master, us
+    int       avgPhaseError = 0;
+    int       maxPhaseError = 0;
+};
+
+// Tracks the clock of the MultiSync master from timestamped sync packets.
+// The master stamps each sync packet with the time on its monotonic clock
+// that the frame started.  From those the remote estimates the offset and
+// drift between the two clocks, filtering out network delay by tracking
+// the packets with the smallest delay, and the master's frame period.
+// The output thread then asks when a frame should start on the local
+// monotonic clock instead of nudging its frame delay from frame numbers.
+class MasterFrameClock {
+public:
+    static MasterFrameClock INSTANCE;
+
+    MasterFrameClock();
+
+    // forget everything, used when the master changes
+    void Reset();
+    // forget the master's frame timeline but keep the clock estimates,
+    // used when a new sequence is opened or started
+    void ResetFrames();
+
+    // The master started frame at masterTime on its clock and the packet
+    // arrived at localTime on ours
+    void AddSyncPoint(uint32_t frame, long long masterTime, long long localTime);
+
+    // Local monotonic time the master started or will start the frame,
+    // returns false if there are not enough recent sync points to know
+    bool GetFrameTime(uint32_t frame, long long now, long long &localTime);
+    int  GetFramePeriod();
+
+    // how far off the start of a frame was from the master, called by
+    // the output thread once per frame
+    void AddPhaseError(int us);
+
+    void GetStats(MasterClockStats &stats);
+
+private:
+    bool isLocked(long long now);
+    long long offsetAt(long long localTime);
+
+    class OffsetSample {
+    public:
+        long long localTime = 0;
+        long long offset = 0;
+    };
+    class FrameSample {
+    public:
+        uint32_t  frame = 0;
+        long long masterTime = 0;
+    };
+
+    std::mutex lock;
+
+    OffsetSample offsets[MASTER_CLOCK_OFFSET_SAMPLES];
+    int          offsetCount;
+    int          offsetPos;
+    OffsetSample blockBest;
+    int          blockSamples;
+    OffsetSample blocks[MASTER_CLOCK_DRIFT_BLOCKS];
+    int          blockCount;
+    int          blockPos;
+    long long    envelopeTime;
+    long long    envelopeOffset;
+    double       drift;
+    double       jitter;
+
+    FrameSample  frames[MASTER_CLOCK_FRAME_SAMPLES];
+    int          frameCount;
+    int          framePos;
+    double       framePeriod;
+
+    int          phaseError;
+    double       avgPhaseError;
+    int          maxPhaseError;
+};
@@ -48,6 +48,8 @@ class Matrix {
 	void OverlaySubMatrix(unsigned char *channelData, int i);
 	void OverlaySubMatrices(unsigned char *channelData);
 
+	bool HasSubMatrices() const { return !subMatrix.empty(); }
+
   private:
 	int  m_startChannel;
 	int  m_width;
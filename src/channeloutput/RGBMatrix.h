@@ -47,6 +47,8 @@ class RGBMatrixOutput : public ChannelOutputBase {
 	virtual int Close(void) override;
 
 	virtual void PrepData(unsigned char *channelData) override;
+	// the sub matrices are copied into the channel data
+	virtual bool PrepDataInSerial() override { return m_matrix && m_matrix->HasSubMatrices(); }
 
 	virtual int SendData(unsigned char *channelData) override;
 
@@ -28,7 +28,9 @@
 #include <curl/curl.h>
 
 #include "UDPOutput.h"
+#include "channeloutput.h"
 #include "ping.h"
+#include "util/ChannelDataCompare.h"
 
 #include "NetworkMonitor.h"
 
@@ -114,7 +116,8 @@ void UDPOutputMessages::clearSockets() {
 UDPOutput* UDPOutput::INSTANCE = nullptr;
 
 UDPOutputData::UDPOutputData(const Json::Value &config)
-:  valid(true), type(0), monitor(true), failCount(0), lastData(nullptr), skippedFrames(0) {
+:  valid(true), type(0), monitor(true), failCount(0), lastData(nullptr), skippedFrames(0),
+  dirtyGeneration(0), dirtyRangesValid(false) {
     
     if (config.isMember("description")) {
         description = config["description"].asString();
@@ -183,7 +186,7 @@ void UDPOutputData::SaveFrame(unsigned char *channelData, int len) {
                channelData[0], channelData[1], channelData[2], channelData[3], channelData[4], channelData[5],
                channelData[6], channelData[7], channelData[8], channelData[9], channelData[10], channelData[11]);
          */
-        memcpy(lastData, channelData, len);
+        ChannelDataCopyIfDifferent(lastData, channelData, len);
     }
 }
 
@@ -192,23 +195,17 @@ bool UDPOutputData::NeedToOutputFrame(unsigned char *channelData, int startChann
         if (lastData == nullptr) {
             return true;
         }
-        for (int x = 0; x < count; x++) {
-            if (channelData[x + savedIdx + startChannel] != lastData[x + savedIdx]) {
-                /*
-                printf("ND: %d   %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", x,
-                       lastData[0], lastData[1], lastData[2], lastData[3], lastData[4], lastData[5],
-                       lastData[6], lastData[7], lastData[8], lastData[9], lastData[10], lastData[11]);
-                printf("%d %d    %2X%2X%2X %2X%2X%2X %2X%2X%2X %2X%2X%2X\n", start, startChannel, x,
-                       channelData[start + startChannel + 0], channelData[start + startChannel + 1], channelData[start + startChannel + 2],
-                       channelData[start + startChannel + 3], channelData[start + startChannel + 4], channelData[start + startChannel + 5],
-                       channelData[start + startChannel + 6], channelData[start + startChannel + 7], channelData[start + startChannel + 8],
-                       channelData[start + startChannel + 9], channelData[start + startChannel + 10], channelData[start + startChannel + 11]);
-                 printf("New data %d  %d  %d      %X %X\n", x, startChannel, savedIdx, channelData[x + savedIdx + startChannel], lastData[x + savedIdx]);
-                 */
-                return true;
-            }
+        const DirtyChannelRanges &dirty = GetDirtyChannelRanges();
+        if (dirty.getGeneration() != dirtyGeneration) {
+            // first check of a new frame, the dirty ranges can only be
+            // trusted if lastData was checked against the previous frame
+            dirtyRangesValid = dirty.getGeneration() == (dirtyGeneration + 1);
+            dirtyGeneration = dirty.getGeneration();
+        }
+        if (dirtyRangesValid && !dirty.isDirty(startChannel + savedIdx, count)) {
+            return false;
         }
-        return false;
+        return ChannelDataDiffers(&channelData[savedIdx + startChannel], &lastData[savedIdx], count);
     }
     skippedFrames = 0;
     return true;
@@ -107,6 +107,11 @@ protected:
     int            skippedFrames;
     unsigned char* lastData;
 
+    // generation of the last DirtyChannelRanges seen and whether
+    // lastData matches the frame before it
+    uint64_t       dirtyGeneration;
+    bool           dirtyRangesValid;
+
 };
 
 class UDPOutput : public ChannelOutputBase {
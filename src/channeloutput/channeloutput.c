@@ -41,7 +41,9 @@
 #include "settings.h"
 #include "channeloutput.h"
 #include "ChannelOutputBase.h"
+#include "FrameTiming.h"
 #include "Warnings.h"
+#include "util/WorkerPool.h"
 
 //old style that still need porting
 #include "FPD.h"
@@ -60,6 +62,9 @@ static int LoadOutputProcessors(void);
 OutputProcessors         outputProcessors;
 
 static std::vector<std::pair<uint32_t, uint32_t>> outputRanges;
+static DirtyChannelRanges dirtyChannelRanges;
+static uint32_t outputProcessorsChangeCount = 0;
+static WorkerPool *prepWorkers = nullptr;
 
 const std::vector<std::pair<uint32_t, uint32_t>> &GetOutputRanges() {
     if (outputRanges.empty()) {
@@ -214,6 +219,8 @@ int InitializeChannelOutputs(void) {
 		bzero(&channelOutputs[i], sizeof(channelOutputs[i]));
 	}
 
+	FrameTimingStats::INSTANCE.ClearOutputs();
+
 	// Reset index so we can start populating the outputs array
 	i = 0;
 	if (FPDOutput.isConfigured()) {
@@ -229,6 +236,7 @@ int InitializeChannelOutputs(void) {
                     m1, m2);
             
             addRange(m1, m2);
+            FrameTimingStats::INSTANCE.SetOutputInfo(i, "FPD", m1, channelOutputs[i].channelCount);
             
 			i++;
 			LogDebug(VB_CHANNELOUT, "Configured FPD Channel Output\n");
@@ -350,6 +358,7 @@ int InitializeChannelOutputs(void) {
                     LogInfo(VB_CHANNELOUT, "%s %d:  Determined range needed %d - %d\n",
                             type.c_str(), i, m1, m2);
                     addRange(m1, m2);
+                    FrameTimingStats::INSTANCE.SetOutputInfo(i, type, m1, channelOutputs[i].channelCount);
 					i++;
                 } else if (channelOutputs[i].output) {
                     
@@ -360,6 +369,7 @@ int InitializeChannelOutputs(void) {
                             addRange(m1, m2);
 
                         });
+                        FrameTimingStats::INSTANCE.SetOutputInfo(i, type, start, count);
                         i++;
                     } else {
                         WarningHolder::AddWarning("Could not initialize output type " + type + ". Check logs for details.");
@@ -398,6 +408,18 @@ int InitializeChannelOutputs(void) {
         LogInfo(VB_CHANNELOUT, "Determined range needed %d - %d\n", r.first, r.first + r.second - 1);
     }
 
+    int prepOutputs = 0;
+    for (i = 0; i < channelOutputCount; i++) {
+        if (channelOutputs[i].output) {
+            prepOutputs++;
+        }
+    }
+    int cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (!prepWorkers && (prepOutputs > 1) && (cores > 1) && getSettingInt("ParallelOutputPrep", 1)) {
+        LogDebug(VB_CHANNELOUT, "Preparing channel outputs on %d threads\n", std::min(prepOutputs, cores));
+        prepWorkers = new WorkerPool("FPP-OutputPrep", std::min(prepOutputs, cores));
+    }
+
 	return 1;
 }
 
@@ -418,14 +440,69 @@ void ResetChannelOutputFrameNumber(void) {
 }
 
 
-int PrepareChannelData(char *channelData) {
+const DirtyChannelRanges &GetDirtyChannelRanges() {
+    return dirtyChannelRanges;
+}
+
+bool PrepareChannelDataModifiesData(void) {
+    if (outputProcessors.HasActiveProcessors()) {
+        return true;
+    }
+    for (int i = 0; i < channelOutputCount; i++) {
+        if (channelOutputs[i].output && channelOutputs[i].output->PrepDataInSerial()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PrepChannelOutput(int i, char *channelData) {
+    long long startTime = GetTime();
+    channelOutputs[i].output->PrepData((unsigned char *)channelData);
+    FrameTimingStats::INSTANCE.AddOutputPrepTime(i, GetTime() - startTime);
+}
+
+int PrepareChannelData(char *channelData, const DirtyChannelRanges *dirtyRanges) {
+    uint64_t generation = dirtyChannelRanges.getGeneration() + 1;
+    uint32_t changeCount = outputProcessors.GetChangeCount();
+    if (dirtyRanges
+        && changeCount == outputProcessorsChangeCount
+        && outputProcessors.IsChannelPreserving()) {
+        dirtyChannelRanges.clear();
+        dirtyChannelRanges.add(*dirtyRanges);
+    } else {
+        //the processors may move data between channels, we cannot
+        //tell what changed
+        dirtyChannelRanges.setAllDirty();
+    }
+    dirtyChannelRanges.setGeneration(generation);
+    outputProcessorsChangeCount = changeCount;
+    // sort and merge the ranges now, the outputs may call isDirty from
+    // the prep workers at the same time and it must not modify the set
+    dirtyChannelRanges.getRanges();
+
     outputProcessors.ProcessData((unsigned char *)channelData);
-    FPPChannelOutputInstance *inst;
+
+    // outputs that need to be prepared in order are done first, the
+    // rest are independent of each other and can be prepared in parallel
+    std::vector<int> parallel;
     for (int i = 0; i < channelOutputCount; i++) {
-        inst = &channelOutputs[i];
-        if (inst->output) {
-            inst->output->PrepData((unsigned char *)channelData);
+        if (channelOutputs[i].output) {
+            if (prepWorkers && !channelOutputs[i].output->PrepDataInSerial()) {
+                parallel.push_back(i);
+            } else {
+                PrepChannelOutput(i, channelData);
+            }
+        }
+    }
+    if (!parallel.empty()) {
+        // the calling thread does the last one itself
+        for (int x = 0; x < parallel.size() - 1; x++) {
+            int i = parallel[x];
+            prepWorkers->submit([i, channelData]() { PrepChannelOutput(i, channelData); });
         }
+        PrepChannelOutput(parallel.back(), channelData);
+        prepWorkers->wait();
     }
     return 0;
 }
@@ -446,14 +523,19 @@ int SendChannelData(const char *channelData) {
 
     for (i = 0; i < channelOutputCount; i++) {
         inst = &channelOutputs[i];
+        unsigned int channels = inst->channelCount < (FPPD_MAX_CHANNELS - inst->startChannel) ? inst->channelCount : (FPPD_MAX_CHANNELS - inst->startChannel);
+        long long startTime = GetTime();
         if (inst->outputOld) {
             inst->outputOld->send(
                     inst->privData,
                     channelData + inst->startChannel,
-                    inst->channelCount < (FPPD_MAX_CHANNELS - inst->startChannel) ? inst->channelCount : (FPPD_MAX_CHANNELS - inst->startChannel));
+                    channels);
         } else if (inst->output) {
             inst->output->SendData((unsigned char *)(channelData + inst->startChannel));
+        } else {
+            continue;
         }
+        FrameTimingStats::INSTANCE.AddOutputSendTime(i, GetTime() - startTime, channels);
     }
 
     return 0;
@@ -493,6 +575,11 @@ void StopOutputThreads(void) {
 void CloseChannelOutputs(void) {
 	int i = 0;
 
+    if (prepWorkers) {
+        delete prepWorkers;
+        prepWorkers = nullptr;
+    }
+
 	for (i = channelOutputCount-1; i >= 0; i--) {
 		if (channelOutputs[i].outputOld)
 			channelOutputs[i].outputOld->close(channelOutputs[i].privData);
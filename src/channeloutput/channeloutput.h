@@ -28,6 +28,8 @@
 #include <pthread.h>
 #include <stdint.h>
 
+#include "DirtyChannelRanges.h"
+
 #define FPPD_MAX_CHANNEL_OUTPUTS   64
 
 class ChannelOutputBase;
@@ -64,7 +66,10 @@ extern float           mediaElapsedSeconds;
 extern OutputProcessors outputProcessors;
 
 int  InitializeChannelOutputs(void);
-int  PrepareChannelData(char *channelData);
+int  PrepareChannelData(char *channelData, const DirtyChannelRanges *dirtyRanges = nullptr);
+// true if the output processors or outputs may write to the channel data
+// passed to PrepareChannelData
+bool PrepareChannelDataModifiesData(void);
 int  SendChannelData(const char *channelData);
 void CloseChannelOutputs(void);
 void SetChannelOutputFrameNumber(int frameNumber);
@@ -73,3 +78,6 @@ void StartOutputThreads(void);
 void StopOutputThreads(void);
 
 const std::vector<std::pair<uint32_t, uint32_t>> &GetOutputRanges();
+
+// The channels that changed in the frame currently being prepared/sent
+const DirtyChannelRanges &GetDirtyChannelRanges();
@@ -27,23 +27,29 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
+#include <sched.h>
 #include <string.h>
+#include <sys/prctl.h>
 #include <sys/time.h>
 #include <unistd.h>
 #include <mutex>
 #include <thread>
 
 #include "channeloutput.h"
+#include "FrameTiming.h"
+#include "MasterFrameClock.h"
 #include "common.h"
 #include "effects.h"
 #include "fppd.h"
 #include "log.h"
 #include "MultiSync.h"
 #include "overlays/PixelOverlay.h"
+#include "Plugins.h"
 #include "Sequence.h"
 #include "settings.h"
 
 #include "mediaoutput/SDLOut.h"
+#include "util/WorkerPool.h"
 
 /* used by external sync code */
 float   RefreshRate = 20;
@@ -67,8 +73,17 @@ std::mutex outputThreadStatusLock;
 std::condition_variable outputThreadCond;
 std::condition_variable outputThreadSatusCond;
 
+// Waking up from a sleep can be a few hundred us late on a busy system so
+// the end of the wait for a frame is spent spinning instead
+#define FRAME_SPIN_TIME 250
+
+// SCHED_FIFO priority for OutputThreadRealtime, below the kernel's
+// threaded interrupt handlers (50)
+#define OUTPUT_THREAD_PRIORITY 40
+
 /* prototypes for functions below */
 void CalculateNewChannelOutputDelayForFrame(int expectedFramesSent);
+static bool ScheduleRemoteFrame(long long frameTime, long long startMonoTime, unsigned long sentFrame);
 
 /*
  * Check to see if the channel output thread is running
@@ -107,6 +122,95 @@ static inline bool forceOutput() {
         outputForced;
 }
 
+/*
+ * Apply the real-time scheduling and CPU pinning settings to the calling
+ * thread
+ */
+static void SetupOutputThreadScheduling(void)
+{
+    // frames are scheduled to the us, don't let the kernel delay wakeups
+    // to batch them with others
+    prctl(PR_SET_TIMERSLACK, 1);
+
+    if (getSettingInt("OutputThreadRealtime")) {
+        struct sched_param param;
+        param.sched_priority = OUTPUT_THREAD_PRIORITY;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc)
+            LogWarn(VB_CHANNELOUT, "Could not make the channel output thread real-time: %s\n", strerror(rc));
+        else
+            LogDebug(VB_CHANNELOUT, "Channel output thread using SCHED_FIFO priority %d\n", OUTPUT_THREAD_PRIORITY);
+    }
+
+    int cpu = getSettingInt("OutputThreadCPU", -1);
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (rc)
+            LogWarn(VB_CHANNELOUT, "Could not pin the channel output thread to CPU %d: %s\n", cpu, strerror(rc));
+        else
+            LogDebug(VB_CHANNELOUT, "Channel output thread pinned to CPU %d\n", cpu);
+    }
+}
+
+/*
+ * Wait until frameTime on the monotonic clock.  The wait is on the
+ * condition variable so ForceChannelOutputNow can still wake the thread
+ * early, wait_until with the steady clock is an absolute wait on
+ * CLOCK_MONOTONIC.  The last spinTime us are spent spinning.  Returns
+ * true if the wait was cut short.
+ */
+static bool WaitForFrameTime(std::unique_lock<std::mutex> &lock, long long frameTime, int spinTime)
+{
+    long long sleepUntil = frameTime - spinTime;
+    if (sleepUntil > GetMonotonicTime()) {
+        std::chrono::steady_clock::time_point tp{std::chrono::microseconds(sleepUntil)};
+        if (outputThreadCond.wait_until(lock, tp) == std::cv_status::no_timeout)
+            return true;
+    }
+    while (GetMonotonicTime() < frameTime) {
+    }
+    return false;
+}
+
+/*
+ * Read the next frame of the sequence and apply effects, overlays, etc to
+ * it.  When pipelined this runs on the pipeline thread while the current
+ * frame is being sent and the outputs prepare the frame afterwards.  The
+ * effects and overlays only write to the frame being processed, presets
+ * triggered by the control channel are run from PrepareSequenceData on
+ * the output thread.  Plugins may modify the channel data or send it
+ * themselves so pipelining is never used while plugins are loaded.
+ */
+static void ReadAndProcessFrame(int onceMore, bool prepare, long long &readDuration, long long &processDuration,
+                                bool *deferred = nullptr)
+{
+    long long startTime = GetTime();
+    if (sequence->IsSequenceRunning() || (onceMore >= 1)) {
+        if (FrameSkip && sequence->IsSequenceRunning()) {
+            sequence->SeekSequenceFile(channelOutputFrame + FrameSkip + 1);
+            FrameSkip = 0;
+        }
+        sequence->ReadSequenceData(false, deferred);
+        if (deferred && *deferred) {
+            readDuration = GetTime() - startTime;
+            processDuration = 0;
+            return;
+        }
+    }
+    long long readTime = GetTime();
+    readDuration = readTime - startTime;
+
+    int msTime = 1000.0 * channelOutputFrame / RefreshRate;
+    if (!sequence->IsSequenceRunning()) {
+        msTime = mediaElapsedSeconds * 1000;
+    }
+    sequence->ProcessSequenceData(msTime, 1, prepare);
+    processDuration = GetTime() - readTime;
+}
+
 /*
  * Main loop in channel output thread
  */
@@ -115,8 +219,15 @@ void *RunChannelOutputThread(void *data)
 	static long long lastStatTime = 0;
 	long long startTime;
 	long long sendTime;
-	long long readTime;
     long long processTime;
+    long long readDuration;
+    long long processDuration;
+    long long frameTime = 0;
+    long long lastStartMonoTime = 0;
+    bool onSchedule = false;
+    long long startMonoTime;
+    unsigned long sentFrame;
+    bool remoteClockLocked = false;
     int onceMore = (getFPPmode() == REMOTE_MODE) ? 20 : 1;
 	struct timespec ts;
     struct timeval tv;
@@ -124,6 +235,18 @@ void *RunChannelOutputThread(void *data)
 
     alwaysTransmit = getSettingInt("alwaysTransmit");
 
+    // spinning only makes sense if there is another core to do other work
+    int spinTime = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? FRAME_SPIN_TIME : 0;
+    SetupOutputThreadScheduling();
+
+    // with a spare core, read and process the next frame while sending
+    // the current one
+    WorkerPool *pipelineWorker = nullptr;
+    if (getSettingInt("OutputThreadPipeline") && (sysconf(_SC_NPROCESSORS_ONLN) > 1)) {
+        LogDebug(VB_CHANNELOUT, "Using pipelined channel output\n");
+        pipelineWorker = new WorkerPool("FPP-OutPipeline", 1);
+    }
+
 	LogDebug(VB_CHANNELOUT, "RunChannelOutputThread() starting\n");
 
     std::unique_lock<std::mutex> lock(outputThreadLock);
@@ -152,6 +275,22 @@ void *RunChannelOutputThread(void *data)
 
 	while (RunThread) {
 		startTime = GetTime();
+        startMonoTime = GetMonotonicTime();
+        sentFrame = channelOutputFrame;
+
+        int lateness = 0;
+        if (onSchedule) {
+            lateness = startMonoTime - frameTime;
+            if (lateness > LightDelay) {
+                // missed by more than a frame, start over from now instead
+                // of rushing frames out to catch up
+                frameTime = startMonoTime;
+            }
+        } else {
+            frameTime = startMonoTime;
+            lastStartMonoTime = 0;
+            onSchedule = true;
+        }
 		if ((getFPPmode() == MASTER_MODE) && sequence->IsSequenceRunning()) {
             multiSync->SendSeqSyncPacket(
                 sequence->m_seqFilename, channelOutputFrame,
@@ -160,6 +299,8 @@ void *RunChannelOutputThread(void *data)
 		}
 
         bool doForceOutput = forceOutput();
+        bool pipelined = false;
+        bool readDeferred = false;
         if (OutputFrames) {
             if (!sequence->isDataProcessed()) {
                 //first time through or immediately after sequence load, the data might not be
@@ -177,30 +318,39 @@ void *RunChannelOutputThread(void *data)
                     std::this_thread::sleep_for(std::chrono::milliseconds(1));
                     loops++;
                 }
+            }
+            pipelined = pipelineWorker && (getFPPmode() != BRIDGE_MODE)
+                && !PluginManager::INSTANCE.hasPlugins() && sequence->IsSequenceRunning();
+            sequence->SelectOutputBuffer(pipelined);
+            if (pipelined) {
+                int once = onceMore;
+                pipelineWorker->submit([once, &readDuration, &processDuration, &readDeferred]() {
+                    ReadAndProcessFrame(once, false, readDuration, processDuration, &readDeferred);
+                });
             }
 			sequence->SendSequenceData();
         }
 
 		sendTime = GetTime();
 
-        if (getFPPmode() != BRIDGE_MODE) {
-            if (sequence->IsSequenceRunning() || (onceMore >= 1)) {
-                if (FrameSkip && sequence->IsSequenceRunning()) {
-                    sequence->SeekSequenceFile(channelOutputFrame + FrameSkip + 1);
-                    FrameSkip = 0;
-                }
-                sequence->ReadSequenceData();
-            }
-            readTime = GetTime();
-            
-            int msTime = 1000.0 * channelOutputFrame / RefreshRate;
-            if (!sequence->IsSequenceRunning()) {
-                msTime = mediaElapsedSeconds * 1000;
+        if (pipelined) {
+            // the outputs are only prepared once they're done sending
+            pipelineWorker->wait();
+            if (readDeferred) {
+                // the sequence ended or was stopped, close/blank it here
+                // now that nothing is being sent
+                ReadAndProcessFrame(onceMore, true, readDuration, processDuration);
+            } else {
+                long long prepStart = GetTime();
+                sequence->PrepareSequenceData();
+                processDuration += GetTime() - prepStart;
             }
-            sequence->ProcessSequenceData(msTime, 1);
+        } else if (getFPPmode() != BRIDGE_MODE) {
+            ReadAndProcessFrame(onceMore, true, readDuration, processDuration);
         } else {
             sequence->setDataNotProcessed();
-            readTime = GetTime();
+            readDuration = 0;
+            processDuration = 0;
         }
 
 		processTime = GetTime();
@@ -221,8 +371,8 @@ void *RunChannelOutputThread(void *data)
                  "SLOW Output Thread: Loop: %dus, Send: %lldus, Read: %lldus, Process: %lldus, FrameNum: %ld\n",
             LightDelay,
             sendTime - startTime,
-            readTime - sendTime,
-            processTime - readTime,
+            readDuration,
+            processDuration,
             channelOutputFrame);
         }
 
@@ -233,7 +383,15 @@ void *RunChannelOutputThread(void *data)
 		{
             // REMOTE mode keeps looping a few extra times before we blank
             onceMore = (getFPPmode() == REMOTE_MODE) ? 20 : 1;
-            int sleepTime = LightDelay - (processTime - startTime);
+            if ((getFPPmode() == REMOTE_MODE) && sequence->IsSequenceRunning()) {
+                bool locked = ScheduleRemoteFrame(frameTime, startMonoTime, sentFrame);
+                if (remoteClockLocked && !locked) {
+                    LogDebug(VB_CHANNELOUT, "Lost the master clock, falling back to frame number sync\n");
+                    LightDelay = DefaultLightDelay;
+                }
+                remoteClockLocked = locked;
+            }
+            int sleepTime = (frameTime + LightDelay) - (startMonoTime + (processTime - startTime));
 			if ((channelOutputFrame <= 1) || (sleepTime <= 0) || (startTime > (lastStatTime + 1000000))) {
 				if (sleepTime < 0)
 					sleepTime = 0;
@@ -244,10 +402,22 @@ void *RunChannelOutputThread(void *data)
                          "Output Thread: Loop: %dus, Send: %lldus, Read: %lldus, Process: %lldus, Sleep: %dus, FrameNum: %ld\n",
 					LightDelay,
                     sendTime - startTime,
-					readTime - sendTime,
-                    processTime - readTime, 
+					readDuration,
+                    processDuration,
                     sleepTime, channelOutputFrame);
 			}
+
+            FrameTimingSample sample;
+            sample.frame = channelOutputFrame;
+            sample.lightDelay = LightDelay;
+            sample.send = sendTime - startTime;
+            sample.read = readDuration;
+            sample.process = processDuration;
+            sample.sleep = sleepTime > 0 ? sleepTime : 0;
+            sample.lateness = lateness;
+            sample.interval = lastStartMonoTime ? (startMonoTime - lastStartMonoTime) : 0;
+            FrameTimingStats::INSTANCE.AddSample(sample);
+            lastStartMonoTime = startMonoTime;
 		} else {
 			LightDelay = DefaultLightDelay;
 
@@ -262,6 +432,7 @@ void *RunChannelOutputThread(void *data)
                     statusLock.unlock();
                     outputThreadSatusCond.notify_all();
                     onceMore = 1;
+                    onSchedule = false;
                     continue;
                 } else {
                     RunThread = 0;
@@ -271,15 +442,20 @@ void *RunChannelOutputThread(void *data)
 		}
         statusLock.unlock();
 
-		// Calculate how long we need to nanosleep()
-		long dt = (LightDelay - (GetTime() - startTime)) * 1000;
-		if (RunThread && dt > 0) {
-            if (outputThreadCond.wait_for(lock, std::chrono::nanoseconds(dt)) == std::cv_status::no_timeout ) {
-				LogDebug(VB_CHANNELOUT, "Forced output\n");
-			}
+		// Frames are scheduled against absolute deadlines so the time it
+		// takes to wake up doesn't add up frame after frame
+        frameTime += LightDelay;
+		if (RunThread && WaitForFrameTime(lock, frameTime, spinTime)) {
+            LogDebug(VB_CHANNELOUT, "Forced output\n");
+            // woken early on purpose, not a timing problem
+            onSchedule = false;
         }
 	}
 	StopOutputThreads();
+    if (pipelineWorker) {
+        delete pipelineWorker;
+        sequence->SelectOutputBuffer(false);
+    }
     statusLock.lock();
     ThreadIsRunning = 0;
     statusLock.unlock();
@@ -294,6 +470,47 @@ void *RunChannelOutputThread(void *data)
 	pthread_exit(NULL);
 }
 
+/*
+ * Work out LightDelay for a remote from the master's clock so the next
+ * frame starts when the master starts it.  Small phase errors are slewed
+ * out by stretching or shrinking the frame by up to 25%, anything over
+ * two frames is fixed by skipping or holding frames.  Returns false if
+ * the master clock is not known, in which case the frame number based
+ * adjustments in CalculateNewChannelOutputDelayForFrame are used.
+ */
+static bool ScheduleRemoteFrame(long long frameTime, long long startMonoTime, unsigned long sentFrame)
+{
+    MasterFrameClock &clock = MasterFrameClock::INSTANCE;
+    long long now = GetMonotonicTime();
+    long long target;
+
+    if (!clock.GetFrameTime(sentFrame, now, target))
+        return false;
+    clock.AddPhaseError(startMonoTime - target);
+
+    // channelOutputFrame is now the frame that will be sent next
+    clock.GetFrameTime(channelOutputFrame, now, target);
+    int period = clock.GetFramePeriod();
+    long long sleepTime = target - now;
+
+    if (!FrameSkip) {
+        if (sleepTime < -2 * period) {
+            FrameSkip = -sleepTime / period;
+            LogDebug(VB_CHANNELOUT, "Behind master clock by %lldus, skipping %d frames\n", -sleepTime, FrameSkip);
+        } else if (sleepTime > 2 * period) {
+            FrameSkip = -1;
+            LogDebug(VB_CHANNELOUT, "Ahead of master clock by %lldus, holding frame\n", sleepTime);
+        }
+    }
+
+    long long delay = target - frameTime;
+    delay = std::max(delay, (long long)(period * 3 / 4));
+    delay = std::min(delay, (long long)(period * 5 / 4));
+    LightDelay = delay;
+
+    return true;
+}
+
 /*
  * Set the step time
  */
@@ -415,6 +632,7 @@ void StopForcingChannelOutput(void)
 void ResetMasterPosition(void)
 {
 	MasterFramesPlayed = -1;
+    MasterFrameClock::INSTANCE.ResetFrames();
 }
 
 /*
@@ -423,7 +641,12 @@ void ResetMasterPosition(void)
 void UpdateMasterPosition(int frameNumber)
 {
 	MasterFramesPlayed = frameNumber;
-	CalculateNewChannelOutputDelayForFrame(frameNumber);
+
+    // with timestamped sync packets the output thread schedules frames
+    // from the master's clock
+    long long frameTime;
+    if (!MasterFrameClock::INSTANCE.GetFrameTime(frameNumber, GetMonotonicTime(), frameTime))
+        CalculateNewChannelOutputDelayForFrame(frameNumber);
 }
 
 /*
@@ -25,7 +25,7 @@
 #include "log.h"
 
 
-OutputProcessors::OutputProcessors() {
+OutputProcessors::OutputProcessors() : changeCount(0) {
 }
 OutputProcessors::~OutputProcessors() {
     for (OutputProcessor *a : processors) {
@@ -49,10 +49,12 @@ void OutputProcessors::addProcessor(OutputProcessor*p) {
     }
     std::lock_guard<std::mutex> lock(processorsLock);
     processors.push_back(p);
+    changeCount++;
 }
 void OutputProcessors::removeProcessor(OutputProcessor*p) {
     std::lock_guard<std::mutex> lock(processorsLock);
     processors.remove(p);
+    changeCount++;
 }
 void OutputProcessors::removeAll() {
     std::lock_guard<std::mutex> lock(processorsLock);
@@ -60,6 +62,7 @@ void OutputProcessors::removeAll() {
         delete a;
     }
     processors.clear();
+    changeCount++;
 }
 
 void OutputProcessors::loadFromJSON(const Json::Value &config, bool clear) {
@@ -111,6 +114,33 @@ OutputProcessor *OutputProcessors::find(std::function<bool(OutputProcessor*)> f)
     return nullptr;
 }
 
+bool OutputProcessors::HasActiveProcessors() const {
+    std::lock_guard<std::mutex> lock(processorsLock);
+    for (OutputProcessor *a : processors) {
+        if (a->isActive()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OutputProcessors::IsChannelPreserving() const {
+    std::lock_guard<std::mutex> lock(processorsLock);
+    for (OutputProcessor *a : processors) {
+        if (a->isActive()) {
+            switch (a->getType()) {
+                case OutputProcessor::BRIGHTNESS:
+                case OutputProcessor::SETVALUE:
+                case OutputProcessor::HOLDVALUE:
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
 void OutputProcessors::GetRequiredChannelRanges(const std::function<void(int, int)> &addRange) {
     for (OutputProcessor *a : processors) {
         a->GetRequiredChannelRanges(addRange);
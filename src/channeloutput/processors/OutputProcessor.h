@@ -21,6 +21,7 @@
 #include <list>
 #include <mutex>
 #include <functional>
+#include <atomic>
 #include <jsoncpp/json/json.h>
 
 #include "../../Sequence.h"
@@ -66,10 +67,19 @@ public:
     void loadFromJSON(const Json::Value &config, bool clear = true);
     
     void GetRequiredChannelRanges(const std::function<void(int, int)> &addRange);
+
+    // True if every active processor only modifies each channel based on
+    // that channel's own value.  If so, channels that did not change on
+    // input will not change on output.
+    bool IsChannelPreserving() const;
+    bool HasActiveProcessors() const;
+    // incremented whenever processors are added or removed
+    uint32_t GetChangeCount() const { return changeCount; }
 protected:
     void removeAll();
     OutputProcessor *create(const Json::Value &config);
     
     mutable std::mutex processorsLock;
     std::list<OutputProcessor*> processors;
+    std::atomic<uint32_t> changeCount;
 };
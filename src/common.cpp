@@ -79,6 +79,16 @@ long long GetTimeMS(void) {
     return now_tv.tv_sec * 1000LL + now_tv.tv_usec / 1000;
 }
 
+/*
+ * Microseconds on a clock that is never stepped by NTP or date changes,
+ * only useful for measuring intervals
+ */
+long long GetMonotonicTime(void) {
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    return now_ts.tv_sec * 1000000LL + now_ts.tv_nsec / 1000;
+}
+
 std::string GetTimeStr(std::string fmt)
 {
     auto t = std::time(nullptr);
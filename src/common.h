@@ -66,6 +66,7 @@
 
 long long GetTime(void);
 long long GetTimeMS(void);
+long long GetMonotonicTime(void);
 std::string GetTimeStr(std::string fmt);
 std::string GetDateStr(std::string fmt);
 
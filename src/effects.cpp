@@ -329,7 +329,7 @@ int OverlayEffect(int effectID, char *channelData)
     e->currentFrame++;
     if (d) {
         d->readFrame((uint8_t*)channelData, FPPD_MAX_CHANNELS);
-        delete d;
+        d->release();
         return 1;
     } else {
         StopEffectHelper(effectID);
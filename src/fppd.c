@@ -857,6 +857,8 @@ void CreateDaemon(void)
     close(STDIN_FILENO);
     close(STDOUT_FILENO);
     close(STDERR_FILENO);
+
+    RestartLogWriter();
 }
 
 void PublishStatsForce(std::string reason) {
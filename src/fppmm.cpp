@@ -59,7 +59,8 @@ void usage(char *appname) {
     printf("                            VALUE of -1 will delete the range\n");
 	printf("   -m MODEL               - List info about Pixel Overlay MODEL\n");
 	printf("   -m MODEL -o MODE       - Set Pixel Overlay mode, Mode is one of:\n");
-	printf("                            off, on, transparent, transparentrgb\n");
+	printf("                            off, on, transparent, transparentrgb,\n");
+	printf("                            additive, max, alpha\n");
 	printf("   -m MODEL -f FILENAME   - Copy raw FILENAME data to MODEL\n" );
 	printf("   -m MODEL -s VALUE      - Fill MODEL with VALUE for all channels\n");
 	printf("   -h                     - This help output\n");
@@ -103,6 +104,12 @@ static void parseArguments(int argc, char **argv) {
 							isActive = 2;
 						else if (!strcmp(optarg, "transparentrgb"))
 							isActive = 3;
+						else if (!strcmp(optarg, "additive"))
+							isActive = 4;
+						else if (!strcmp(optarg, "max"))
+							isActive = 5;
+						else if (!strcmp(optarg, "alpha"))
+							isActive = 6;
 
 						break;
 			case 'f':	inputFilename = strdup(optarg);
@@ -257,6 +264,12 @@ void DumpMappedBlockInfo(const std::string &blockName) {
                 break;
         case 3: printf("Active (Transparent RGB)\n");
                 break;
+        case 4: printf("Active (Additive)\n");
+                break;
+        case 5: printf("Active (Maximum)\n");
+                break;
+        case 6: printf("Active (Alpha, opacity %d)\n", v["opacity"].asInt());
+                break;
     }
 
     printf( "Effect running : ");
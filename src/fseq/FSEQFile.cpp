@@ -12,6 +12,7 @@
 #include <mutex>
 #include <map>
 #include <list>
+#include <algorithm>
 #include <condition_variable>
 
 #include <chrono>
@@ -53,7 +54,10 @@ int gettimeofday(struct timeval * tp, struct timezone * tzp)
 
 #else
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <signal.h>
+#include <setjmp.h>
 #endif
 
 #include "FSEQFile.h"
@@ -123,6 +127,162 @@ inline void AddSlowStorageWarning() {
 
 using FrameData = FSEQFile::FrameData;
 
+//Read only mapping of an uncompressed fseq file.  Frames are copied out
+//of the mapping on the reader thread, nothing outside of getMappedFrame
+//holds pointers into it.
+class FSEQFileMapping {
+public:
+    FSEQFileMapping(uint8_t *d, uint64_t sz) : data(d), size(sz) {}
+    ~FSEQFileMapping() {
+#ifndef PLATFORM_UNKNOWN
+        munmap(data, size);
+#endif
+    }
+
+    uint8_t *data;
+    uint64_t size;
+};
+
+class UncompressedFrameData : public FSEQFile::FrameData {
+public:
+    UncompressedFrameData(uint32_t frame,
+                          uint32_t sz,
+                          const std::vector<std::pair<uint32_t, uint32_t>> &ranges)
+    : FrameData(frame), m_ranges(ranges) {
+        m_size = sz;
+        m_capacity = sz;
+        m_data = (uint8_t*)malloc(sz);
+    }
+    virtual ~UncompressedFrameData() {
+        if (m_data != nullptr) {
+            free(m_data);
+        }
+    }
+
+    //reinitialize a recycled frame, the buffer is only reallocated if it's too small
+    void reset(uint32_t f,
+               uint32_t sz,
+               const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+        frame = f;
+        if (sz > m_capacity || m_data == nullptr) {
+            if (m_data != nullptr) {
+                free(m_data);
+            }
+            m_data = (uint8_t*)malloc(sz);
+            m_capacity = sz;
+        }
+        m_size = sz;
+        m_ranges = ranges;
+        m_hasDirtyRanges = false;
+        m_dirtyRanges.clear();
+    }
+
+    virtual bool readFrame(uint8_t *data, uint32_t maxChannels) override {
+        const uint8_t *src = m_data;
+        if (src == nullptr) return false;
+        uint32_t offset = 0;
+        for (auto &rng : m_ranges) {
+            uint32_t toRead = rng.second;
+            if (offset + toRead <= m_size) {
+                uint32_t toCopy = std::min(toRead, maxChannels - rng.first);
+                memcpy(&data[rng.first], &src[offset], toCopy);
+                offset += toRead;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+    virtual void release() override;
+    virtual bool getDirtyRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges) const override {
+        if (m_hasDirtyRanges) {
+            ranges = m_dirtyRanges;
+        }
+        return m_hasDirtyRanges;
+    }
+
+    uint32_t m_size;
+    uint32_t m_capacity;
+    uint8_t *m_data;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+    std::shared_ptr<FrameDataPool> m_pool;
+
+    bool m_hasDirtyRanges = false;
+    std::vector<std::pair<uint32_t, uint32_t>> m_dirtyRanges;
+};
+
+//Frames handed out by getFrame are recycled through this pool so that
+//steady state playback does not need to malloc/free a full frame buffer
+//for every frame.  The pool is shared by the FSEQFile and the frames it
+//created as frames may be released after the FSEQFile is deleted.
+static const int FSEQ_FRAME_POOL_SIZE = 64;
+
+class FrameDataPool : public std::enable_shared_from_this<FrameDataPool> {
+public:
+    FrameDataPool() : m_closed(false), m_hits(0), m_misses(0) {
+        m_frames.reserve(FSEQ_FRAME_POOL_SIZE);
+    }
+    ~FrameDataPool() {
+        close();
+    }
+
+    UncompressedFrameData *getFrame(uint32_t frame,
+                                    uint32_t sz,
+                                    const std::vector<std::pair<uint32_t, uint32_t>> &ranges) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (!m_frames.empty()) {
+            UncompressedFrameData *data = m_frames.back();
+            m_frames.pop_back();
+            lock.unlock();
+            m_hits++;
+            data->reset(frame, sz, ranges);
+            return data;
+        }
+        lock.unlock();
+        m_misses++;
+        UncompressedFrameData *data = new UncompressedFrameData(frame, sz, ranges);
+        data->m_pool = shared_from_this();
+        return data;
+    }
+    void recycle(UncompressedFrameData *data) {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (!m_closed && m_frames.size() < FSEQ_FRAME_POOL_SIZE) {
+            m_frames.push_back(data);
+            return;
+        }
+        lock.unlock();
+        delete data;
+    }
+    //called when the owning file is closed, any frames released after
+    //this point are deleted instead of pooled
+    void close() {
+        std::vector<UncompressedFrameData*> frames;
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_closed = true;
+        frames.swap(m_frames);
+        lock.unlock();
+        for (auto f : frames) {
+            delete f;
+        }
+    }
+
+    std::mutex m_lock;
+    std::vector<UncompressedFrameData*> m_frames;
+    bool m_closed;
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+};
+
+void UncompressedFrameData::release() {
+    if (m_pool) {
+        //hold a reference as recycle may delete this frame
+        std::shared_ptr<FrameDataPool> pool = m_pool;
+        pool->recycle(this);
+    } else {
+        delete this;
+    }
+}
+
 inline void DumpHeader(const char *title, unsigned char data[], int len) {
     int x = 0;
     char tmpStr[128];
@@ -340,7 +500,11 @@ FSEQFile::FSEQFile(const std::string &fn)
     m_seqFileSize(0),
     m_memoryBuffer(),
     m_seqChanDataOffset(0),
-    m_memoryBufferPos(0)
+    m_memoryBufferPos(0),
+    m_framePool(std::make_shared<FrameDataPool>()),
+    m_readAheadBudget(0),
+    m_mapAdviseStart(0),
+    m_mapAdviseEnd(0)
 {
     if (fn == "-memory-") {
         m_seqFile = nullptr;
@@ -379,7 +543,11 @@ FSEQFile::FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t>
     m_seqFile(file),
     m_uniqueId(0),
     m_memoryBuffer(),
-    m_memoryBufferPos(0)
+    m_memoryBufferPos(0),
+    m_framePool(std::make_shared<FrameDataPool>()),
+    m_readAheadBudget(0),
+    m_mapAdviseStart(0),
+    m_mapAdviseEnd(0)
 {
     fseeko(m_seqFile, 0L, SEEK_END);
     m_seqFileSize = ftello(m_seqFile);
@@ -405,6 +573,14 @@ FSEQFile::~FSEQFile() {
     if (m_seqFile) {
         fclose(m_seqFile);
     }
+    m_framePool->close();
+}
+
+uint64_t FSEQFile::getFramePoolHits() const {
+    return m_framePool->m_hits;
+}
+uint64_t FSEQFile::getFramePoolMisses() const {
+    return m_framePool->m_misses;
 }
 
 int FSEQFile::seek(uint64_t location, int origin) {
@@ -451,11 +627,164 @@ void FSEQFile::preload(uint64_t pos, uint64_t size) {
 #endif
 }
 
+//amount of data ahead of the current frame that the kernel is asked to
+//page in for memory mapped files
+static const uint64_t FSEQ_MMAP_ADVISE_SIZE = 8 * 1024 * 1024;
+
+#ifndef PLATFORM_UNKNOWN
+//If a mapped file is truncated (scp, Samba or a file manager overwriting a
+//sequence in place), touching a page past the new end of the file raises
+//SIGBUS.  Frames are copied out of the mapping with this jump buffer set
+//so the handler can bail out of the copy instead of crashing fppd, any
+//other SIGBUS is passed on to the previous handler.
+static thread_local sigjmp_buf *fseqMapCopyJump = nullptr;
+static struct sigaction fseqPrevSigBus;
+static std::mutex fseqSigBusLock;
+
+static void fseqSigBusHandler(int sig, siginfo_t *info, void *ctx) {
+    if (fseqMapCopyJump) {
+        siglongjmp(*fseqMapCopyJump, 1);
+    }
+    if (fseqPrevSigBus.sa_flags & SA_SIGINFO) {
+        fseqPrevSigBus.sa_sigaction(sig, info, ctx);
+    } else if (fseqPrevSigBus.sa_handler != SIG_DFL && fseqPrevSigBus.sa_handler != SIG_IGN) {
+        fseqPrevSigBus.sa_handler(sig);
+    } else {
+        //restore the default action, the faulting access is retried on return
+        sigaction(SIGBUS, &fseqPrevSigBus, nullptr);
+    }
+}
+
+//installed each time a file is mapped in case something else (the fppd
+//crash handler) replaced it since the last time
+static void installSigBusHandler() {
+    std::unique_lock<std::mutex> lock(fseqSigBusLock);
+    struct sigaction cur;
+    if (sigaction(SIGBUS, nullptr, &cur) == 0
+        && (cur.sa_flags & SA_SIGINFO) && cur.sa_sigaction == fseqSigBusHandler) {
+        return;
+    }
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = fseqSigBusHandler;
+    sigemptyset(&act.sa_mask);
+    act.sa_flags = SA_SIGINFO;
+    sigaction(SIGBUS, &act, &fseqPrevSigBus);
+}
+#endif
+
+bool FSEQFile::mapFile() {
+#ifndef PLATFORM_UNKNOWN
+    if (m_mapping) {
+        return true;
+    }
+    if (m_seqFile == nullptr || m_seqFileSize <= m_seqChanDataOffset) {
+        return false;
+    }
+    //don't map a file that's already been truncated or is being rewritten
+    struct stat st;
+    if (fstat(fileno(m_seqFile), &st) != 0 || (uint64_t)st.st_size != m_seqFileSize) {
+        return false;
+    }
+    void *data = mmap(nullptr, m_seqFileSize, PROT_READ, MAP_SHARED, fileno(m_seqFile), 0);
+    if (data == MAP_FAILED) {
+        LogWarn(VB_SEQUENCE, "Could not memory map %s, reading with file I/O.  Error: %s\n", m_filename.c_str(), strerror(errno));
+        return false;
+    }
+    installSigBusHandler();
+    madvise(data, m_seqFileSize, MADV_SEQUENTIAL);
+    m_mapping = std::make_shared<FSEQFileMapping>((uint8_t*)data, m_seqFileSize);
+    m_mapAdviseStart = 0;
+    m_mapAdviseEnd = 0;
+    LogDebug(VB_SEQUENCE, "Memory mapped %s, %" PRIu64 " bytes\n", m_filename.c_str(), m_seqFileSize);
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifndef PLATFORM_UNKNOWN
+//copies the frame out of the mapping, returns false if the file was
+//truncated underneath us and the copy faulted
+static bool copyMappedFrame(uint8_t *dst,
+                            const uint8_t *frameData,
+                            uint32_t frameSize,
+                            const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+                            uint32_t dataSize,
+                            bool packed) {
+    sigjmp_buf jump;
+    if (sigsetjmp(jump, 1)) {
+        fseqMapCopyJump = nullptr;
+        return false;
+    }
+    fseqMapCopyJump = &jump;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    if (packed) {
+        memcpy(dst, frameData, dataSize);
+    } else {
+        //the mapping has the full frame, pack the ranges like a normal read
+        uint32_t sz = 0;
+        for (auto &rng : ranges) {
+            if (rng.first < frameSize) {
+                uint32_t toCopy = std::min(rng.second, frameSize - rng.first);
+                memcpy(&dst[sz], &frameData[rng.first], toCopy);
+                if (toCopy < rng.second) {
+                    memset(&dst[sz + toCopy], 0, rng.second - toCopy);
+                }
+                sz += rng.second;
+            }
+        }
+    }
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    fseqMapCopyJump = nullptr;
+    return true;
+}
+#endif
+
+FrameData *FSEQFile::getMappedFrame(uint32_t frame,
+                                    uint32_t frameSize,
+                                    const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+                                    uint32_t dataSize,
+                                    bool packed) {
+#ifndef PLATFORM_UNKNOWN
+    if (!m_mapping) {
+        return nullptr;
+    }
+    uint64_t offset = frameSize;
+    offset *= frame;
+    offset += m_seqChanDataOffset;
+    if ((offset + frameSize) > m_mapping->size) {
+        return nullptr;
+    }
+    if (offset < m_mapAdviseStart || (offset + FSEQ_MMAP_ADVISE_SIZE / 2) > m_mapAdviseEnd) {
+        //let the kernel know we'll need the next chunk of the file soon
+        static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        m_mapAdviseStart = offset - (offset % pageSize);
+        m_mapAdviseEnd = std::min(m_mapAdviseStart + FSEQ_MMAP_ADVISE_SIZE, m_mapping->size);
+        madvise(&m_mapping->data[m_mapAdviseStart], m_mapAdviseEnd - m_mapAdviseStart, MADV_WILLNEED);
+    }
+
+    //copy the frame into a pooled buffer here on the reader thread so the
+    //output thread never touches the mapping
+    UncompressedFrameData *data = m_framePool->getFrame(frame, dataSize, ranges);
+    if (!copyMappedFrame(data->m_data, &m_mapping->data[offset], frameSize, ranges, dataSize, packed)) {
+        LogWarn(VB_SEQUENCE, "%s was truncated while being read, no longer memory mapping it\n", m_filename.c_str());
+        data->release();
+        m_mapping.reset();
+        return nullptr;
+    }
+    return data;
+#else
+    return nullptr;
+#endif
+}
+
 inline bool isRecognizedVariableHeader(uint8_t a, uint8_t b) {
     // mf - media filename
     // sp - sequence producer
+    // zs - frames per zstd seek point
     // see https://github.com/FalconChristmas/fpp/blob/master/docs/FSEQ_Sequence_File_Format.txt#L48 for more information
-    return (a == 'm' && b == 'f') || (a == 's' && b == 'p');
+    return (a == 'm' && b == 'f') || (a == 's' && b == 'p') || (a == 'z' && b == 's');
 }
 
 void FSEQFile::parseVariableHeaders(const std::vector<uint8_t> &header, int readIndex) {
@@ -629,42 +958,6 @@ V1FSEQFile::V1FSEQFile(const std::string &fn, FILE *file, const std::vector<uint
 V1FSEQFile::~V1FSEQFile() {
 }
 
-class UncompressedFrameData : public FSEQFile::FrameData {
-public:
-    UncompressedFrameData(uint32_t frame,
-                          uint32_t sz,
-                          const std::vector<std::pair<uint32_t, uint32_t>> &ranges)
-    : FrameData(frame), m_ranges(ranges) {
-        m_size = sz;
-        m_data = (uint8_t*)malloc(sz);
-    }
-    virtual ~UncompressedFrameData() {
-        if (m_data != nullptr) {
-            free(m_data);
-        }
-    }
-
-    virtual bool readFrame(uint8_t *data, uint32_t maxChannels) override {
-        if (m_data == nullptr) return false;
-        uint32_t offset = 0;
-        for (auto &rng : m_ranges) {
-            uint32_t toRead = rng.second;
-            if (offset + toRead <= m_size) {
-                uint32_t toCopy = std::min(toRead, maxChannels - rng.first);
-                memcpy(&data[rng.first], &m_data[offset], toCopy);
-                offset += toRead;
-            } else {
-                return false;
-            }
-        }
-        return true;
-    }
-
-    uint32_t m_size;
-    uint8_t *m_data;
-    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
-};
-
 void V1FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t startFrame) {
     m_rangesToRead = ranges;
     m_dataBlockSize = 0;
@@ -677,9 +970,10 @@ void V1FSEQFile::prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &r
         }
         m_dataBlockSize += toRead;
     }
+    mapFile();
     FrameData *f = getFrame(startFrame);
     if (f) {
-        delete f;
+        f->release();
     }
 }
 
@@ -689,11 +983,15 @@ FrameData *V1FSEQFile::getFrame(uint32_t frame) {
         range.push_back(std::pair<uint32_t, uint32_t>(0, m_seqChannelCount));
         prepareRead(range, frame);
     }
+    FrameData *mapped = getMappedFrame(frame, m_seqChannelCount, m_rangesToRead, m_dataBlockSize, false);
+    if (mapped) {
+        return mapped;
+    }
     uint64_t offset = m_seqChannelCount;
     offset *= frame;
     offset += m_seqChanDataOffset;
 
-    UncompressedFrameData *data = new UncompressedFrameData(frame, m_dataBlockSize, m_rangesToRead);
+    UncompressedFrameData *data = m_framePool->getFrame(frame, m_dataBlockSize, m_rangesToRead);
     if (seek(offset, SEEK_SET)) {
         LogErr(VB_SEQUENCE, "Failed to seek to proper offset for channel data for frame %d! %" PRIu64 "\n", frame, offset);
         return data;
@@ -736,6 +1034,7 @@ static const int V2FSEQ_COMPRESSION_BLOCK_SIZE = 8;
 #if !defined(NO_ZLIB) || !defined(NO_ZSTD)
 static const int V2FSEQ_OUT_BUFFER_SIZE = 1024 * 1024; // 1MB output buffer
 static const int V2FSEQ_OUT_BUFFER_FLUSH_SIZE = 900 * 1024; // 90% full, flush it
+static const int V2FSEQ_SEEK_POINT_SIZE = 256 * 1024; // max uncompressed bytes between zstd seek points
 static const int V2FSEQ_OUT_COMPRESSION_BLOCK_SIZE = 64 * 1024; // 64KB blocks
 #endif
 
@@ -772,9 +1071,23 @@ public:
     void preload(uint64_t pos, uint64_t size) {
         m_file->preload(pos, size);
     }
+    UncompressedFrameData *getFrameData(uint32_t frame) {
+        return m_file->m_framePool->getFrame(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+    }
+    bool mapFile() {
+        return m_file->mapFile();
+    }
+    FrameData *getMappedFrame(uint32_t frame) {
+        return m_file->getMappedFrame(frame, m_file->getChannelCount(), m_file->m_rangesToRead,
+                                      m_file->m_dataBlockSize, !m_file->m_sparseRanges.empty());
+    }
 
     virtual void prepareRead(uint32_t frame) {}
 
+    virtual uint64_t getBlocksDecodedAhead() const { return 0; }
+    virtual uint64_t getDecodeStalls() const { return 0; }
+    virtual uint64_t getDecodedBytesResident() const { return 0; }
+
     V2FSEQFile *m_file;
     uint64_t   m_seqChanDataOffset;
 };
@@ -787,13 +1100,18 @@ public:
     virtual uint8_t getCompressionType() override { return 0;}
     virtual std::string GetType() const override { return "No Compression"; }
     virtual void prepareRead(uint32_t frame) override {
+        mapFile();
         FrameData *f = getFrame(frame);
         if (f) {
-            delete f;
+            f->release();
         }
     }
     virtual FrameData *getFrame(uint32_t frame) override {
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        FrameData *mapped = getMappedFrame(frame);
+        if (mapped) {
+            return mapped;
+        }
+        UncompressedFrameData *data = getFrameData(frame);
         uint64_t offset = m_file->getChannelCount();
         offset *= frame;
         offset += m_seqChanDataOffset;
@@ -1032,6 +1350,70 @@ public:
         return data;
     }
 
+    //like getBlock, but ownership of the compressed data is passed to the
+    //caller which must free it.  Returns nullptr if running is cleared
+    //before the block could be read.
+    uint8_t *takeBlock(int block, const std::atomic_bool &running) {
+        std::unique_lock<std::mutex> readerlock(m_readMutex);
+        uint8_t *data = m_blockMap[block];
+        if (data == nullptr) {
+            m_blocksToRead.push_front(block);
+            m_readSignal.notify_all();
+        }
+        while (data == nullptr && running && m_readThreadRunning) {
+            m_readSignal.wait_for(readerlock, 100ms);
+            data = m_blockMap[block];
+        }
+        m_blockMap[block] = nullptr;
+        return data;
+    }
+    void requestBlock(int block) {
+        if (block < m_file->m_frameOffsets.size() - 1) {
+            uint64_t pos = m_file->m_frameOffsets[block].second;
+            preload(pos, m_file->m_frameOffsets[block + 1].second - pos);
+        }
+        std::unique_lock<std::mutex> readerlock(m_readMutex);
+        if (m_blockMap[block] == nullptr) {
+            m_blocksToRead.push_back(block);
+            m_readSignal.notify_all();
+        }
+    }
+    int findBlock(uint32_t frame) {
+        int block = 0;
+        while (frame >= m_file->m_frameOffsets[block + 1].first) {
+            block++;
+        }
+        return block;
+    }
+    uint64_t compressedBlockSize(int block) {
+        uint64_t size = m_file->m_frameOffsets[block + 1].second - m_file->m_frameOffsets[block].second;
+        uint64_t max = m_file->getNumFrames();
+        max *= m_file->getChannelCount();
+        return size > max ? max : size;
+    }
+    uint64_t uncompressedBlockSize(int block) {
+        uint32_t last = m_file->m_frameOffsets[block + 1].first;
+        if (last > m_file->getNumFrames()) {
+            last = m_file->getNumFrames();
+        }
+        uint64_t frames = last > m_file->m_frameOffsets[block].first ? last - m_file->m_frameOffsets[block].first : 0;
+        return frames * m_file->getChannelCount();
+    }
+    void copyFrameData(UncompressedFrameData *data, const uint8_t *fdata) {
+        if (!m_file->m_sparseRanges.empty()) {
+            memcpy(data->m_data, fdata, m_file->getChannelCount());
+        } else {
+            uint32_t sz = 0;
+            //read the ranges into the buffer
+            for (auto &rng : data->m_ranges) {
+                if (rng.first < m_file->getChannelCount()) {
+                    memcpy(&data->m_data[sz], &fdata[rng.first], rng.second);
+                    sz += rng.second;
+                }
+            }
+        }
+    }
+
     // for compressed files, this is the compression data
     uint32_t m_framesPerBlock;
     uint32_t m_curFrameInBlock;
@@ -1052,7 +1434,11 @@ class V2ZSTDCompressionHandler : public V2CompressedHandler {
 public:
     V2ZSTDCompressionHandler(V2FSEQFile *f) : V2CompressedHandler(f),
     m_cctx(nullptr),
-    m_dctx(nullptr)
+    m_dctx(nullptr),
+    m_decodeThreadsRunning(false),
+    m_blocksDecodedAhead(0),
+    m_decodeStalls(0),
+    m_decodedBytesResident(0)
     {
         m_outBuffer.pos = 0;
         m_outBuffer.size = V2FSEQ_OUT_BUFFER_SIZE;
@@ -1063,6 +1449,19 @@ public:
         LogDebug(VB_SEQUENCE, "  Prepared to read/write a ZSTD compress fseq file.\n");
     }
     virtual ~V2ZSTDCompressionHandler() {
+        if (!m_decodeThreads.empty()) {
+            m_decodeThreadsRunning = false;
+            m_decodeSignal.notify_all();
+            for (auto t : m_decodeThreads) {
+                t->join();
+                delete t;
+            }
+        }
+        for (auto &a : m_decodedBlocks) {
+            if (a.second.data) {
+                free(a.second.data);
+            }
+        }
         free(m_outBuffer.dst);
         if (m_cctx) {
             ZSTD_freeCStream(m_cctx);
@@ -1074,7 +1473,20 @@ public:
     virtual uint8_t getCompressionType() override { return 1;}
     virtual std::string GetType() const override { return "Compressed ZSTD"; }
 
+    virtual uint64_t getBlocksDecodedAhead() const override { return m_blocksDecodedAhead; }
+    virtual uint64_t getDecodeStalls() const override { return m_decodeStalls; }
+    virtual uint64_t getDecodedBytesResident() const override { return m_decodedBytesResident; }
+
     virtual FrameData *getFrame(uint32_t frame) override {
+        if (m_file->getReadAheadBudget() && !m_file->m_frameOffsets.empty()) {
+            int block = findBlock(frame);
+            if (uncompressedBlockSize(block) <= m_file->getReadAheadBudget()) {
+                FrameData *data = getDecodedFrame(frame, block);
+                if (data) {
+                    return data;
+                }
+            }
+        }
         if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
             //frame is not in the current block
             m_curBlock = 0;
@@ -1108,18 +1520,39 @@ public:
             m_outBuffer.dst = malloc(m_outBuffer.size);
             m_outBuffer.pos = 0;
             m_curFrameInBlock = 0;
+            m_firstFrameInBuffer = 0;
+            findSeekPoints();
         }
         uint32_t fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
 
+        if (!m_seekPoints.empty()) {
+            //restart decompression at the seek point for the frame if it's
+            //before what has been decoded or beyond the current seek point
+            uint32_t point = fidx / m_file->m_framesPerSeekPoint;
+            uint32_t pointFrame = point * m_file->m_framesPerSeekPoint;
+            if (point < m_seekPoints.size() && (fidx < m_firstFrameInBuffer || pointFrame > m_curFrameInBlock)) {
+                ZSTD_initDStream(m_dctx);
+                m_inBuffer.pos = m_seekPoints[point];
+                m_outBuffer.pos = (size_t)pointFrame * m_file->getChannelCount();
+                m_curFrameInBlock = pointFrame;
+                m_firstFrameInBuffer = pointFrame;
+            }
+        }
         if (fidx >= m_curFrameInBlock) {
             m_outBuffer.size = (fidx + 1) * m_file->getChannelCount();
-            ZSTD_decompressStream(m_dctx, &m_outBuffer, &m_inBuffer);
+            //the block may contain multiple zstd frames and decompressStream
+            //stops at the end of each one
+            while (m_outBuffer.pos < m_outBuffer.size && m_inBuffer.pos < m_inBuffer.size) {
+                if (ZSTD_isError(ZSTD_decompressStream(m_dctx, &m_outBuffer, &m_inBuffer))) {
+                    break;
+                }
+            }
             m_curFrameInBlock = fidx + 1;
         }
         
         fidx *= m_file->getChannelCount();
         uint8_t *fdata = (uint8_t*)m_outBuffer.dst;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        UncompressedFrameData *data = getFrameData(frame);
 
         // This stops the crash on load ... but it is not the root cause.
         // But better to not load completely than crashing
@@ -1144,6 +1577,24 @@ public:
         }
         return data;
     }
+    //record the offset of each zstd frame within the current block.  Each
+    //one starts at a multiple of m_framesPerSeekPoint frames.
+    void findSeekPoints() {
+        m_seekPoints.clear();
+        if (!m_file->m_framesPerSeekPoint || !m_inBuffer.src) {
+            return;
+        }
+        const uint8_t *src = (const uint8_t*)m_inBuffer.src;
+        size_t pos = 0;
+        while (pos < m_inBuffer.size) {
+            size_t sz = ZSTD_findFrameCompressedSize(&src[pos], m_inBuffer.size - pos);
+            if (ZSTD_isError(sz) || sz == 0) {
+                break;
+            }
+            m_seekPoints.push_back(pos);
+            pos += sz;
+        }
+    }
     void compressData(ZSTD_CStream* m_cctx, ZSTD_inBuffer_s &input, ZSTD_outBuffer_s &output) {
         ZSTD_compressStream(m_cctx, &output, &input);
         int count = input.pos;
@@ -1187,7 +1638,16 @@ public:
             if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
                 clevel = 0;
             }
+            m_blockCompressionLevel = clevel;
             ZSTD_initCStream(m_cctx, clevel);
+        } else if (m_file->m_framesPerSeekPoint && (m_curFrameInBlock % m_file->m_framesPerSeekPoint) == 0) {
+            //end the zstd frame and start a new one so readers can
+            //start decompressing here without the earlier frames
+            while (ZSTD_endStream(m_cctx, &m_outBuffer) > 0) {
+                write(m_outBuffer.dst, m_outBuffer.pos);
+                m_outBuffer.pos = 0;
+            }
+            ZSTD_initCStream(m_cctx, m_blockCompressionLevel);
         }
 
         uint8_t *curData = (uint8_t *)data;
@@ -1247,10 +1707,493 @@ public:
         V2CompressedHandler::finalize();
     }
 
+
+    //Blocks within the read ahead budget are decompressed in full by a
+    //pool of decode threads ahead of the frames being requested so that
+    //getFrame only needs to copy the frame out of an already decoded block
+    enum DecodeState {
+        Queued,
+        Decoding,
+        Ready,
+        Failed,
+        Streaming
+    };
+    class DecodedBlock {
+    public:
+        DecodeState state = Queued;
+        uint8_t *data = nullptr;
+        uint64_t size = 0;
+        bool accessed = false;
+    };
+
+    FrameData *getDecodedFrame(uint32_t frame, int block) {
+        std::unique_lock<std::mutex> lock(m_decodeMutex);
+        if (m_decodeThreads.empty()) {
+            startDecodeThreads();
+        }
+        if (block != m_decodeWindowStart || m_decodeWindowEnd == 0) {
+            scheduleDecode(block);
+        }
+        DecodedBlock &db = m_decodedBlocks[block];
+        if (db.state == Queued && m_file->m_framesPerSeekPoint) {
+            //the block hasn't been started, with seek points it's quicker
+            //to decode from the nearest seek point on this thread than to
+            //wait for the entire block to be decoded
+            m_blocksToDecode.remove(block);
+            db.state = Streaming;
+        }
+        if (db.state == Queued || db.state == Decoding) {
+            m_decodeStalls++;
+            if (db.state == Queued) {
+                //make sure it's the next block decoded
+                m_blocksToDecode.remove(block);
+                m_blocksToDecode.push_front(block);
+                m_decodeSignal.notify_all();
+            }
+            while (db.state == Queued || db.state == Decoding) {
+                if (m_decodeSignal.wait_for(lock, 10s) == std::cv_status::timeout) {
+                    AddSlowStorageWarning();
+                    LogWarn(VB_SEQUENCE, "Decoded block %d not available when needed for frame %d.\n", block, frame);
+                }
+            }
+        } else if (!db.accessed && db.state == Ready) {
+            m_blocksDecodedAhead++;
+        }
+        db.accessed = true;
+        if (db.state != Ready) {
+            //fall back to decompressing on this thread
+            return nullptr;
+        }
+        uint64_t fidx = frame - m_file->m_frameOffsets[block].first;
+        fidx *= m_file->getChannelCount();
+        if (fidx + m_file->getChannelCount() > db.size) {
+            return nullptr;
+        }
+        const uint8_t *fdata = &db.data[fidx];
+        //only this thread removes blocks within the window so the
+        //data remains valid after unlocking
+        lock.unlock();
+
+        UncompressedFrameData *data = getFrameData(frame);
+        copyFrameData(data, fdata);
+        return data;
+    }
+
+    //m_decodeMutex must be held
+    void scheduleDecode(int block) {
+        uint64_t budget = m_file->getReadAheadBudget();
+        int lastBlock = m_file->m_frameOffsets.size() - 2;
+        uint64_t total = 0;
+        int end = block;
+        while (end <= lastBlock) {
+            uint64_t sz = uncompressedBlockSize(end);
+            if (total + sz > budget) {
+                break;
+            }
+            total += sz;
+            end++;
+        }
+        m_decodeWindowStart = block;
+        m_decodeWindowEnd = end;
+
+        //release anything that is no longer in the window
+        auto it = m_decodedBlocks.begin();
+        while (it != m_decodedBlocks.end()) {
+            if (it->first >= block && it->first < end) {
+                ++it;
+            } else if (it->second.state == Decoding) {
+                //decode thread will free it when done
+                ++it;
+            } else {
+                if (it->second.state == Queued) {
+                    m_blocksToDecode.remove(it->first);
+                }
+                if (it->second.data) {
+                    free(it->second.data);
+                    m_decodedBytesResident -= it->second.size;
+                }
+                it = m_decodedBlocks.erase(it);
+            }
+        }
+        for (int b = block; b < end; b++) {
+            if (m_decodedBlocks.find(b) == m_decodedBlocks.end()) {
+                m_decodedBlocks[b].state = Queued;
+                m_blocksToDecode.push_back(b);
+                requestBlock(b);
+            }
+        }
+        m_decodeSignal.notify_all();
+    }
+
+    //m_decodeMutex must be held
+    void startDecodeThreads() {
+        int numThreads = std::thread::hardware_concurrency();
+        numThreads = numThreads > 2 ? numThreads - 1 : 1;
+        if (numThreads > 4) {
+            numThreads = 4;
+        }
+        LogDebug(VB_SEQUENCE, "Starting %d ZSTD decode threads, read ahead budget %" PRIu64 " bytes\n", numThreads, m_file->getReadAheadBudget());
+        m_decodeThreadsRunning = true;
+        for (int x = 0; x < numThreads; x++) {
+            m_decodeThreads.push_back(new std::thread([this]() {
+                decodeThreadLoop();
+            }));
+        }
+    }
+
+    void decodeThreadLoop() {
+        ZSTD_DStream *dctx = ZSTD_createDStream();
+        std::unique_lock<std::mutex> lock(m_decodeMutex);
+        while (m_decodeThreadsRunning) {
+            if (m_blocksToDecode.empty()) {
+                m_decodeSignal.wait_for(lock, 25ms);
+                continue;
+            }
+            int block = m_blocksToDecode.front();
+            m_blocksToDecode.pop_front();
+            auto it = m_decodedBlocks.find(block);
+            if (it == m_decodedBlocks.end() || it->second.state != Queued) {
+                continue;
+            }
+            it->second.state = Decoding;
+            lock.unlock();
+
+            uint64_t inSize = compressedBlockSize(block);
+            uint64_t outSize = uncompressedBlockSize(block);
+            uint8_t *in = takeBlock(block, m_decodeThreadsRunning);
+            uint8_t *out = nullptr;
+            bool ok = false;
+            if (in) {
+                out = (uint8_t*)malloc(outSize);
+            }
+            if (out) {
+                ZSTD_initDStream(dctx);
+                ZSTD_inBuffer_s input = { in, inSize, 0 };
+                ZSTD_outBuffer_s output = { out, outSize, 0 };
+                while (output.pos < output.size && input.pos < input.size) {
+                    if (ZSTD_isError(ZSTD_decompressStream(dctx, &output, &input))) {
+                        break;
+                    }
+                }
+                ok = output.pos == output.size;
+            }
+            if (in) {
+                free(in);
+            }
+            if (!ok) {
+                if (m_decodeThreadsRunning) {
+                    LogWarn(VB_SEQUENCE, "Could not decode block %d ahead of playback.\n", block);
+                }
+                if (out) {
+                    free(out);
+                    out = nullptr;
+                }
+            }
+
+            lock.lock();
+            it = m_decodedBlocks.find(block);
+            if (block < m_decodeWindowStart || block >= m_decodeWindowEnd) {
+                //no longer needed
+                if (out) {
+                    free(out);
+                }
+                m_decodedBlocks.erase(it);
+            } else {
+                it->second.state = ok ? Ready : Failed;
+                it->second.data = out;
+                it->second.size = ok ? outSize : 0;
+                if (ok) {
+                    m_decodedBytesResident += outSize;
+                }
+            }
+            m_decodeSignal.notify_all();
+        }
+        lock.unlock();
+        ZSTD_freeDStream(dctx);
+    }
+
     ZSTD_CStream* m_cctx;
     ZSTD_DStream* m_dctx;
     ZSTD_outBuffer_s m_outBuffer;
     ZSTD_inBuffer_s m_inBuffer;
+    int m_blockCompressionLevel = 1;
+
+    //offsets of the zstd frames within the current block for files
+    //with seek points and the first frame decoded into m_outBuffer
+    std::vector<size_t> m_seekPoints;
+    uint32_t m_firstFrameInBuffer = 0;
+
+    std::mutex m_decodeMutex;
+    std::condition_variable m_decodeSignal;
+    std::vector<std::thread*> m_decodeThreads;
+    std::atomic_bool m_decodeThreadsRunning;
+    std::map<int, DecodedBlock> m_decodedBlocks;
+    std::list<int> m_blocksToDecode;
+    int m_decodeWindowStart = 0;
+    int m_decodeWindowEnd = 0;
+
+    std::atomic<uint64_t> m_blocksDecodedAhead;
+    std::atomic<uint64_t> m_decodeStalls;
+    std::atomic<uint64_t> m_decodedBytesResident;
+};
+
+//Delta encoded blocks start with a key frame containing every channel.
+//Each frame after that only stores the ranges of channels that changed
+//from the previous frame.  The records are zstd compressed:
+//   0-3 - number of ranges
+//   per range: 0-3 start channel, 4-7 channel count, followed by the data
+static const int V2FSEQ_DELTA_MIN_GAP = 8; // unchanged channels needed to split a range
+static const int V2FSEQ_DELTA_DECODE_CHUNK = 64 * 1024;
+
+class V2DeltaCompressionHandler : public V2ZSTDCompressionHandler {
+public:
+    V2DeltaCompressionHandler(V2FSEQFile *f) : V2ZSTDCompressionHandler(f),
+    m_decoded(nullptr),
+    m_decodedSize(0),
+    m_decodedCapacity(0),
+    m_appliedFrame(-1)
+    {
+    }
+    virtual ~V2DeltaCompressionHandler() {
+        if (m_decoded) {
+            free(m_decoded);
+        }
+    }
+    virtual uint8_t getCompressionType() override { return 3;}
+    virtual std::string GetType() const override { return "Compressed ZSTD Delta"; }
+
+    virtual FrameData *getFrame(uint32_t frame) override {
+        if (m_curBlock >= m_file->m_frameOffsets.size() || (frame < m_file->m_frameOffsets[m_curBlock].first) || (frame >= m_file->m_frameOffsets[m_curBlock + 1].first)) {
+            //frame is not in the current block
+            m_curBlock = findBlock(frame);
+            if (m_dctx == nullptr) {
+                m_dctx = ZSTD_createDStream();
+            }
+            ZSTD_initDStream(m_dctx);
+            m_inBuffer.pos = 0;
+            m_inBuffer.size = compressedBlockSize(m_curBlock);
+            m_inBuffer.src = getBlock(m_curBlock);
+
+            if (m_curBlock < m_file->m_frameOffsets.size() - 2) {
+                //let the kernel know that we'll likely need the next block in the near future
+                preloadBlock(m_curBlock + 1);
+            }
+            m_decodedSize = 0;
+            m_recordOffsets.clear();
+            m_appliedFrame = -1;
+            m_frame.resize(m_file->getChannelCount());
+        }
+        int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
+        if (fidx < m_appliedFrame) {
+            //going backwards, start over from the key frame
+            m_appliedFrame = -1;
+        }
+        bool ok = true;
+        while (ok && m_appliedFrame < fidx) {
+            ok = applyRecord(m_appliedFrame + 1);
+            if (ok) {
+                m_appliedFrame++;
+            }
+        }
+        UncompressedFrameData *data = getFrameData(frame);
+        if (!ok) {
+            LogErr(VB_SEQUENCE, "Could not decode delta frame %d.\n", (int)frame);
+            memset(data->m_data, 0, data->m_size);
+            return data;
+        }
+        copyFrameData(data, &m_frame[0]);
+        data->m_hasDirtyRanges = true;
+        data->m_dirtyRanges.clear();
+        for (auto &rng : m_lastRanges) {
+            addDirtyRange(data, rng.first, rng.second);
+        }
+        return data;
+    }
+
+    virtual void addFrame(uint32_t frame, const uint8_t *data) override {
+        if (m_cctx == nullptr) {
+            m_cctx = ZSTD_createCStream();
+        }
+        uint32_t channelCount = m_file->getChannelCount();
+        const uint8_t *curData = data;
+        if (!m_file->m_sparseRanges.empty()) {
+            m_packed.resize(channelCount);
+            uint32_t offset = 0;
+            for (auto &a : m_file->m_sparseRanges) {
+                memcpy(&m_packed[offset], &data[a.first], a.second);
+                offset += a.second;
+            }
+            curData = &m_packed[0];
+        }
+
+        m_lastRanges.clear();
+        if (m_curFrameInBlock == 0) {
+            m_file->m_frameOffsets.push_back(std::pair<uint32_t, uint64_t>(frame, tell()));
+            int clevel = m_file->m_compressionLevel == -99 ? 1 : m_file->m_compressionLevel;
+            if (clevel < -25 || clevel > 25) {
+                clevel = 1;
+            }
+            if (ZSTD_versionNumber() <= 10305 && clevel < 0) {
+                clevel = 0;
+            }
+            ZSTD_initCStream(m_cctx, clevel);
+            //key frame
+            m_lastRanges.push_back(std::pair<uint32_t, uint32_t>(0, channelCount));
+            m_frame.resize(channelCount);
+        } else {
+            findChangedRanges(curData, channelCount);
+        }
+        memcpy(&m_frame[0], curData, channelCount);
+
+        uint8_t buf[8];
+        write4ByteUInt(buf, m_lastRanges.size());
+        ZSTD_inBuffer_s input = { buf, 4, 0 };
+        compressData(m_cctx, input, m_outBuffer);
+        for (auto &rng : m_lastRanges) {
+            write4ByteUInt(buf, rng.first);
+            write4ByteUInt(&buf[4], rng.second);
+            ZSTD_inBuffer_s header = { buf, 8, 0 };
+            compressData(m_cctx, header, m_outBuffer);
+            ZSTD_inBuffer_s channels = { &curData[rng.first], rng.second, 0 };
+            compressData(m_cctx, channels, m_outBuffer);
+        }
+
+        if (m_outBuffer.pos > V2FSEQ_OUT_BUFFER_FLUSH_SIZE) {
+            //buffer is getting full, better flush it
+            write(m_outBuffer.dst, m_outBuffer.pos);
+            m_outBuffer.pos = 0;
+        }
+
+        m_curFrameInBlock++;
+        //same block layout as the ZSTD handler, the first block is
+        //kept small so the first frames are available quickly
+        if ((m_curBlock == 0 && m_curFrameInBlock == 10)
+            || (m_curFrameInBlock >= m_framesPerBlock && m_file->m_frameOffsets.size() < m_maxBlocks)) {
+            while(ZSTD_endStream(m_cctx, &m_outBuffer) > 0) {
+                write(m_outBuffer.dst, m_outBuffer.pos);
+                m_outBuffer.pos = 0;
+            }
+            write(m_outBuffer.dst, m_outBuffer.pos);
+            m_outBuffer.pos = 0;
+            m_curFrameInBlock = 0;
+            m_curBlock++;
+        }
+    }
+
+    //fills m_lastRanges with the ranges that differ from m_frame, runs
+    //separated by only a few unchanged channels are merged
+    void findChangedRanges(const uint8_t *curData, uint32_t channelCount) {
+        const uint8_t *last = &m_frame[0];
+        uint32_t x = 0;
+        while (x < channelCount) {
+            if (curData[x] == last[x]) {
+                x++;
+                continue;
+            }
+            uint32_t start = x;
+            uint32_t end = ++x;
+            while (x < channelCount && (x - end) < V2FSEQ_DELTA_MIN_GAP) {
+                if (curData[x] != last[x]) {
+                    end = x + 1;
+                }
+                x++;
+            }
+            m_lastRanges.push_back(std::pair<uint32_t, uint32_t>(start, end - start));
+        }
+    }
+
+    //decompress until at least sz bytes of the block are available
+    bool ensureDecoded(size_t sz) {
+        while (m_decodedSize < sz) {
+            if (m_inBuffer.pos >= m_inBuffer.size) {
+                return false;
+            }
+            if (m_decodedCapacity < m_decodedSize + V2FSEQ_DELTA_DECODE_CHUNK) {
+                size_t newCapacity = std::max(m_decodedCapacity * 2, m_decodedSize + V2FSEQ_DELTA_DECODE_CHUNK);
+                uint8_t *d = (uint8_t*)realloc(m_decoded, newCapacity);
+                if (d == nullptr) {
+                    return false;
+                }
+                m_decoded = d;
+                m_decodedCapacity = newCapacity;
+            }
+            ZSTD_outBuffer_s output = { m_decoded, m_decodedCapacity, m_decodedSize };
+            if (ZSTD_isError(ZSTD_decompressStream(m_dctx, &output, &m_inBuffer))) {
+                return false;
+            }
+            m_decodedSize = output.pos;
+        }
+        return true;
+    }
+
+    //apply the changed ranges for the given frame in the block to m_frame
+    bool applyRecord(int fidx) {
+        if (fidx >= m_recordOffsets.size()) {
+            //records are found in order, the end of the last record is the start of the next
+            size_t pos = m_recordOffsets.empty() ? 0 : m_recordEnd;
+            m_recordOffsets.push_back(pos);
+        }
+        size_t pos = m_recordOffsets[fidx];
+        if (!ensureDecoded(pos + 4)) {
+            m_recordOffsets.resize(fidx);
+            return false;
+        }
+        uint32_t count = read4ByteUInt(&m_decoded[pos]);
+        pos += 4;
+        uint32_t channelCount = m_file->getChannelCount();
+        m_lastRanges.clear();
+        for (uint32_t x = 0; x < count; x++) {
+            if (!ensureDecoded(pos + 8)) {
+                m_recordOffsets.resize(fidx);
+                return false;
+            }
+            uint32_t start = read4ByteUInt(&m_decoded[pos]);
+            uint32_t len = read4ByteUInt(&m_decoded[pos + 4]);
+            pos += 8;
+            if (start >= channelCount || len > (channelCount - start) || !ensureDecoded(pos + len)) {
+                m_recordOffsets.resize(fidx);
+                return false;
+            }
+            memcpy(&m_frame[start], &m_decoded[pos], len);
+            m_lastRanges.push_back(std::pair<uint32_t, uint32_t>(start, len));
+            pos += len;
+        }
+        if (fidx == m_recordOffsets.size() - 1) {
+            m_recordEnd = pos;
+        }
+        return true;
+    }
+
+    //dirty ranges are reported in sequence channel numbers, not the packed
+    //sparse range offsets used within the file
+    void addDirtyRange(UncompressedFrameData *data, uint32_t start, uint32_t len) {
+        if (m_file->m_sparseRanges.empty()) {
+            data->m_dirtyRanges.push_back(std::pair<uint32_t, uint32_t>(start, len));
+            return;
+        }
+        uint32_t offset = 0;
+        uint32_t end = start + len;
+        for (auto &a : m_file->m_sparseRanges) {
+            uint32_t s = std::max(start, offset);
+            uint32_t e = std::min(end, offset + a.second);
+            if (s < e) {
+                data->m_dirtyRanges.push_back(std::pair<uint32_t, uint32_t>(a.first + s - offset, e - s));
+            }
+            offset += a.second;
+        }
+    }
+
+    //the current frame, fully reconstructed when reading
+    std::vector<uint8_t> m_frame;
+    std::vector<uint8_t> m_packed;
+    std::vector<std::pair<uint32_t, uint32_t>> m_lastRanges;
+
+    uint8_t *m_decoded;
+    size_t m_decodedSize;
+    size_t m_decodedCapacity;
+    std::vector<size_t> m_recordOffsets;
+    size_t m_recordEnd = 0;
+    int m_appliedFrame;
 };
 #endif
 
@@ -1307,7 +2250,7 @@ public:
         int fidx = frame - m_file->m_frameOffsets[m_curBlock].first;
         fidx *= m_file->getChannelCount();
         uint8_t *fdata = (uint8_t*)m_outBuffer;
-        UncompressedFrameData *data = new UncompressedFrameData(frame, m_file->m_dataBlockSize, m_file->m_rangesToRead);
+        UncompressedFrameData *data = getFrameData(frame);
         if (!m_file->m_sparseRanges.empty()) {
             memcpy(data->m_data, &fdata[fidx], m_file->getChannelCount());
         } else {
@@ -1427,6 +2370,13 @@ void V2FSEQFile::createHandler() {
         LogErr(VB_ALL, "No support for zstd compression");
 #else
         m_handler = new V2ZSTDCompressionHandler(this);
+#endif
+        break;
+    case CompressionType::delta:
+#ifdef NO_ZSTD
+        LogErr(VB_ALL, "No support for zstd compression");
+#else
+        m_handler = new V2DeltaCompressionHandler(this);
 #endif
         break;
     case CompressionType::zlib:
@@ -1448,7 +2398,9 @@ V2FSEQFile::V2FSEQFile(const std::string &fn, CompressionType ct, int cl)
     m_compressionType(ct),
     m_compressionLevel(cl),
     m_handler(nullptr),
-    m_allowExtendedBlocks(false)
+    m_allowExtendedBlocks(false),
+    m_seekPointsEnabled(false),
+    m_framesPerSeekPoint(0)
 {
     m_seqVersionMajor = V2FSEQ_MAJOR_VERSION;
     m_seqVersionMinor = V2FSEQ_MINOR_VERSION;
@@ -1477,6 +2429,30 @@ void V2FSEQFile::writeHeader() {
         }
     }
 
+    if (m_compressionType == CompressionType::delta && m_seqVersionMinor < 2) {
+        // delta encoding was added in 2.2
+        m_seqVersionMinor = 2;
+        m_allowExtendedBlocks = true;
+    }
+    if (m_seekPointsEnabled && m_compressionType == CompressionType::zstd && m_seqChannelCount) {
+        // Restart the zstd stream often enough that seeking never needs to
+        // decompress more than about V2FSEQ_SEEK_POINT_SIZE bytes
+        m_framesPerSeekPoint = V2FSEQ_SEEK_POINT_SIZE / m_seqChannelCount;
+        if (m_framesPerSeekPoint == 0) {
+            m_framesPerSeekPoint = 1;
+        }
+        std::string fps = std::to_string(m_framesPerSeekPoint);
+        VariableHeader vheader;
+        vheader.code[0] = 'z';
+        vheader.code[1] = 's';
+        vheader.data.resize(fps.size() + 1);
+        memcpy(&vheader.data[0], fps.c_str(), fps.size() + 1);
+        m_variableHeaders.erase(std::remove_if(m_variableHeaders.begin(), m_variableHeaders.end(), [](const VariableHeader &a) {
+            return a.code[0] == 'z' && a.code[1] == 's';
+        }), m_variableHeaders.end());
+        m_variableHeaders.push_back(vheader);
+    }
+
     // Additional file format documentation available at:
     // https://github.com/FalconChristmas/fpp/blob/master/docs/FSEQ_Sequence_File_Format.txt#L17
 
@@ -1586,9 +2562,11 @@ void V2FSEQFile::writeHeader() {
 V2FSEQFile::V2FSEQFile(const std::string &fn, FILE *file, const std::vector<uint8_t> &header)
 : FSEQFile(fn, file, header),
 m_compressionType(none),
-m_handler(nullptr)
+m_handler(nullptr),
+m_seekPointsEnabled(false),
+m_framesPerSeekPoint(0)
 {
-    if (m_seqVersionMajor == 2 && m_seqVersionMinor > 1) {
+    if (m_seqVersionMajor == 2 && m_seqVersionMinor > 2) {
         LogErr(VB_SEQUENCE, "Unknown minor version: %d.  FSEQ may not load properly.\n", m_seqVersionMinor);
     }
     
@@ -1611,6 +2589,9 @@ m_handler(nullptr)
             case 2:
             m_compressionType = CompressionType::zlib;
             break;
+            case 3:
+            m_compressionType = CompressionType::delta;
+            break;
             default:
             LogErr(VB_SEQUENCE, "Unknown compression type: %d\n", (int)header[20]);
         }
@@ -1692,6 +2673,13 @@ m_handler(nullptr)
         // This will loop and continue reading until it hits padding or m_seqChanDataOffset
         // As long as readPos == headerSize prior to this call, the read is a success
         parseVariableHeaders(header, readPos);
+
+        for (auto &a : m_variableHeaders) {
+            if (a.code[0] == 'z' && a.code[1] == 's' && m_compressionType == CompressionType::zstd) {
+                m_framesPerSeekPoint = strtol((const char *)&a.data[0], nullptr, 10);
+                m_seekPointsEnabled = m_framesPerSeekPoint > 0;
+            }
+        }
     }
 
     createHandler();
@@ -1779,6 +2767,15 @@ FrameData *V2FSEQFile::getFrame(uint32_t frame) {
     }
     return nullptr;
 }
+uint64_t V2FSEQFile::getBlocksDecodedAhead() const {
+    return m_handler ? m_handler->getBlocksDecodedAhead() : 0;
+}
+uint64_t V2FSEQFile::getDecodeStalls() const {
+    return m_handler ? m_handler->getDecodeStalls() : 0;
+}
+uint64_t V2FSEQFile::getDecodedBytesResident() const {
+    return m_handler ? m_handler->getDecodedBytesResident() : 0;
+}
 void V2FSEQFile::addFrame(uint32_t frame,
                           const uint8_t *data) {
     if (m_handler != nullptr) {
@@ -3,6 +3,10 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <memory>
+
+class FrameDataPool;
+class FSEQFileMapping;
 
 class FSEQFile {
 public:
@@ -26,6 +30,15 @@ public:
         virtual ~FrameData() {};
         
         virtual bool readFrame(uint8_t *data, uint32_t maxChannels) = 0;
+
+        //Call when done with the frame.  Frames that came from the
+        //FSEQFile's frame pool are recycled for use by a later getFrame
+        virtual void release() { delete this; }
+
+        //The channel ranges that changed from the previous frame in the
+        //file.  Returns false if that isn't known in which case the
+        //entire frame needs to be treated as changed.
+        virtual bool getDirtyRanges(std::vector<std::pair<uint32_t, uint32_t>> &ranges) const { return false; }
         
         uint32_t frame;
     };
@@ -33,7 +46,8 @@ public:
     enum CompressionType {
         none,
         zstd,
-        zlib
+        zlib,
+        delta
     };
 
 protected:
@@ -67,8 +81,27 @@ public:
     
     //For reading data from the fseq file, returns an object can
     //provide the necessary data in a timely fassion for the given frame
-    //It may not be used right away and will be deleted at some point in the future
+    //It may not be used right away and will be released at some point in the future
     virtual FrameData *getFrame(uint32_t frame) = 0;
+
+    //The channel ranges each frame actually provides after prepareRead,
+    //FrameData::readFrame leaves any other channels untouched
+    virtual const std::vector<std::pair<uint32_t, uint32_t>> &getRangesToRead() const = 0;
+
+    //number of getFrame calls that were able to reuse a pooled FrameData (hits)
+    //and the number that needed to allocate a new one (misses)
+    uint64_t getFramePoolHits() const;
+    uint64_t getFramePoolMisses() const;
+
+    //Memory (in bytes) the reader may use to decompress blocks ahead of
+    //the frames being requested.  0 (the default) disables reading ahead.
+    void setReadAheadBudget(uint64_t bytes) { m_readAheadBudget = bytes; }
+    uint64_t getReadAheadBudget() const { return m_readAheadBudget; }
+
+    //statistics for readers that decompress blocks ahead
+    virtual uint64_t getBlocksDecodedAhead() const { return 0; }
+    virtual uint64_t getDecodeStalls() const { return 0; }
+    virtual uint64_t getDecodedBytesResident() const { return 0; }
     
     //For writing to the fseq file
     virtual void enableMinorVersionFeatures(uint8_t ver) {}
@@ -121,6 +154,24 @@ protected:
     uint64_t write(const void * ptr, uint64_t size);
     uint64_t read(void *ptr, uint64_t size);
     void preload(uint64_t pos, uint64_t size);
+
+    std::shared_ptr<FrameDataPool> m_framePool;
+    uint64_t      m_readAheadBudget;
+
+    //memory map the file for reading uncompressed frames, returns false if
+    //the file could not be mapped and normal file I/O needs to be used.
+    bool mapFile();
+    //returns a FrameData holding a copy of the frame from the mapped file
+    //or nullptr if the frame is not available from the mapping.  If the
+    //file was truncated the mapping is dropped and nullptr is returned.
+    FrameData *getMappedFrame(uint32_t frame,
+                              uint32_t frameSize,
+                              const std::vector<std::pair<uint32_t, uint32_t>> &ranges,
+                              uint32_t dataSize,
+                              bool packed);
+    std::shared_ptr<FSEQFileMapping> m_mapping;
+    uint64_t      m_mapAdviseStart;
+    uint64_t      m_mapAdviseEnd;
     
 private:
     FILE* volatile  m_seqFile;
@@ -138,6 +189,7 @@ public:
   
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t startFrame = 0) override;
     virtual FrameData *getFrame(uint32_t frame) override;
+    virtual const std::vector<std::pair<uint32_t, uint32_t>> &getRangesToRead() const override { return m_rangesToRead; }
 
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -165,6 +217,7 @@ public:
     
     virtual void prepareRead(const std::vector<std::pair<uint32_t, uint32_t>> &ranges, uint32_t startFrame = 0) override;
     virtual FrameData *getFrame(uint32_t frame) override;
+    virtual const std::vector<std::pair<uint32_t, uint32_t>> &getRangesToRead() const override { return m_rangesToRead; }
     
     virtual void writeHeader() override;
     virtual void addFrame(uint32_t frame,
@@ -175,6 +228,10 @@ public:
 
     virtual uint32_t getMaxChannel() const override;
 
+    virtual uint64_t getBlocksDecodedAhead() const override;
+    virtual uint64_t getDecodeStalls() const override;
+    virtual uint64_t getDecodedBytesResident() const override;
+
     virtual void enableMinorVersionFeatures(uint8_t ver) override {
         if (ver == 0) {
             m_allowExtendedBlocks = false;
@@ -184,6 +241,10 @@ public:
             m_allowExtendedBlocks = true;
             m_seqVersionMinor = 1;
         }
+        m_seekPointsEnabled = ver >= 2;
+        if (ver >= 2) {
+            m_seqVersionMinor = 2;
+        }
     }
 
     CompressionType m_compressionType;
@@ -193,6 +254,12 @@ public:
     std::vector<std::pair<uint32_t, uint64_t>> m_frameOffsets;
     uint32_t m_dataBlockSize;
     bool m_allowExtendedBlocks;
+
+    // 2.2+ zstd files restart the compression stream every
+    // m_framesPerSeekPoint frames within a block so any frame
+    // can be decoded without decoding the entire block
+    bool m_seekPointsEnabled;
+    uint32_t m_framesPerSeekPoint;
 private:
     
     void createHandler();
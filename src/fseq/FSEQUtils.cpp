@@ -25,7 +25,7 @@ void usage(char *appname) {
     printf("   -m FSEQFILE       - FSEQ to merge onto the input, ignoring 0\n");
     printf("   -M[ FSEQFILE      - FSEQ to merge onto the input, copy 0\n");
     printf("   -f #              - FSEQ Version\n");
-    printf("   -c (none|zstd|zlib) - Compession type\n");
+    printf("   -c (none|zstd|zlib|delta) - Compession type\n");
     printf("   -l #              - Compression level (-99 for default)\n");
     printf("   -r (#-# | #+#)    - Channel Range.  Use - to separate start/end channel\n");
     printf("                            Use + to separate start channel + num channels\n");
@@ -110,6 +110,8 @@ int parseArguments(int argc, char **argv) {
                     compressionType = V2FSEQFile::CompressionType::zlib;
                 } else if (strcmp(optarg, "zstd") == 0) {
                     compressionType = V2FSEQFile::CompressionType::zstd;
+                } else if (strcmp(optarg, "delta") == 0) {
+                    compressionType = V2FSEQFile::CompressionType::delta;
                 } else {
                     printf("Unknown compression type: %s\n", optarg);
                     exit(EXIT_FAILURE);
@@ -287,13 +289,13 @@ int main(int argc, char *argv[]) {
             for (int x = 0; x < src->getNumFrames(); x++) {
                 FSEQFile::FrameData *fdata = src->getFrame(x);
                 fdata->readFrame(data, 8024*1024);
-                delete fdata;
+                fdata->release();
                 
                 for (auto &m : mergeFseqs) {
                     if (m.srcFile) {
                         FSEQFile::FrameData *fdata = m.srcFile->getFrame(x);
                         fdata->readFrame(mergedata, 8024*1024);
-                        delete fdata;
+                        fdata->release();
                         for (auto &r : m.ranges) {
                             for (int y = 0, idx = r.first; y < r.second; ++y, ++idx) {
                                 if (mergedata[idx] || m.copyZero) {
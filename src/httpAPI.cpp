@@ -27,6 +27,7 @@
 
 #include "channeloutput/channeloutput.h"
 #include "channeloutput/channeloutputthread.h"
+#include "channeloutput/FrameTiming.h"
 #include "e131bridge.h"
 #include "effects.h"
 #include "fpp.h"
@@ -177,6 +178,15 @@ const std::shared_ptr<httpserver::http_response> PlayerResource::render_GET(cons
 
         GetMultiSyncStats(result, reset);
     }
+    else if (url == "outputTiming")
+    {
+        bool reset = false;
+
+        if (req.get_arg("reset") == "1")
+            reset = true;
+
+        GetOutputTimingStats(result, reset);
+    }
     else if (url == "playlists")
     {
         GetCurrentPlaylists(result);
@@ -709,6 +719,9 @@ void PlayerResource::GetCurrentStatus(Json::Value &result)
     for (auto & warn : warnings) {
         result["warnings"].append(warn);
     }
+    // microseconds spent in PrepData by each output, the full timings
+    // are available from fppd/outputTiming
+    result["outputPrepTime"] = FrameTimingStats::INSTANCE.GetOutputPrepTimes();
     if (mode == 1) {
         //bridge mode only returns the base information
         return;
@@ -836,6 +849,10 @@ void PlayerResource::GetCurrentStatus(Json::Value &result)
         result["time_remaining"] = secondsToTime(secsRemaining);
         result["scheduler"] = scheduler->GetInfo();
     }
+
+    if (sequence->IsSequenceRunning()) {
+        sequence->GetSequenceStats(result["sequence_stats"]);
+    }
 }
 
 /*
@@ -894,6 +911,19 @@ void PlayerResource::GetMultiSyncStats(Json::Value &result, bool reset)
         SetErrorResult(result, 400, "MultiSync did not return any systems.");
 }
 
+/*
+ *
+ */
+void PlayerResource::GetOutputTimingStats(Json::Value &result, bool reset)
+{
+    result = FrameTimingStats::INSTANCE.GetStats();
+
+    if (reset)
+        FrameTimingStats::INSTANCE.Reset();
+
+    SetOKResult(result, "");
+}
+
 /*
  *
  */
@@ -52,6 +52,7 @@ class PlayerResource : public http_resource {
 	void GetE131BytesReceived(Json::Value &result);
 	void GetMultiSyncSystems(Json::Value &result, bool localOnly = false);
     void GetMultiSyncStats(Json::Value &result, bool reset = false);
+    void GetOutputTimingStats(Json::Value &result, bool reset = false);
 	void GetPlaylistFileTime(Json::Value &result);
 	void GetPlaylistConfig(Json::Value &result);
 
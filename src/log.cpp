@@ -31,7 +31,12 @@
 #include <sys/types.h>
 #include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <condition_variable>
 #include <sstream>
+#include <thread>
 
 //int logLevel = LOG_INFO;
 //int logMask  = VB_MOST;
@@ -181,6 +186,252 @@ bool WillLog(int level, FPPLoggerInstance &facility) {
     return true;
 }
 
+/*
+ * Log lines are formatted on the calling thread and handed to a writer
+ * thread through a fixed size ring so threads doing time critical work
+ * never wait on the log file.  If the ring is full the line is dropped
+ * and counted rather than blocking the caller.
+ *
+ * The ring is a bounded multi-producer queue where each slot carries a
+ * sequence number telling producers and the consumer whose turn it is.
+ */
+#define LOG_RING_SIZE       1024    /* must be a power of 2 */
+#define LOG_RING_LINE_SIZE  512
+
+class LogRingSlot {
+public:
+	std::atomic<uint32_t> sequence;
+	int   length;
+	char *longLine;     /* malloc'd copy of lines too long for line[] */
+	char  line[LOG_RING_LINE_SIZE];
+};
+
+static LogRingSlot logRing[LOG_RING_SIZE];
+static std::atomic<uint32_t> logRingEnqueuePos(0);
+static uint32_t logRingDequeuePos = 0;
+static std::atomic<uint64_t> logRingDropped(0);
+
+enum LogWriterState {
+	LOG_WRITER_NOT_STARTED,
+	LOG_WRITER_STARTING,
+	LOG_WRITER_RUNNING,
+	LOG_WRITER_SYNC         /* write on the calling thread */
+};
+static std::atomic<int> logWriterState(LOG_WRITER_NOT_STARTED);
+static std::atomic<bool> logWriterRunning(false);
+static std::atomic<bool> logWriterIdle(false);
+static std::thread *logWriterThread = nullptr;
+// Created with the thread and never destroyed, destroying a condition
+// variable waits for its waiters which never finish in a forked child
+static std::mutex *logWriterLock = nullptr;
+static std::condition_variable *logWriterCV = nullptr;
+
+static FILE *OpenLogFile(bool &close)
+{
+	close = false;
+	if (!logFileName[0])
+		return nullptr;
+
+	if (!strcmp(logFileName, "stderr"))
+		return stderr;
+	if (!strcmp(logFileName, "stdout"))
+		return stdout;
+
+	FILE *logFile = fopen(logFileName, "a");
+	if (!logFile) {
+		fprintf(stderr, "Error: Unable to open log file for writing!\n");
+		return stderr;
+	}
+	close = true;
+	return logFile;
+}
+
+static void WriteLogLine(FILE *logFile, const char *line, int len)
+{
+	if (logFile)
+		fwrite(line, 1, len, logFile);
+
+	if (logFile != stderr && strcmp(logFileName, "stdout") && logToStdOut)
+		fwrite(line, 1, len, stdout);
+}
+
+static void DrainLogRing()
+{
+	bool close = false;
+	FILE *logFile = nullptr;
+	bool opened = false;
+
+	static uint64_t droppedReported = 0;
+	uint64_t dropped = logRingDropped.load();
+	if (dropped != droppedReported) {
+		char msg[128];
+		int len = snprintf(msg, sizeof(msg),
+			"Log queue was full, %llu log message(s) dropped\n",
+			(unsigned long long)(dropped - droppedReported));
+		droppedReported = dropped;
+
+		logFile = OpenLogFile(close);
+		opened = true;
+		WriteLogLine(logFile, msg, len);
+	}
+
+	while (true) {
+		LogRingSlot &slot = logRing[logRingDequeuePos & (LOG_RING_SIZE - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != logRingDequeuePos + 1)
+			break;
+
+		if (!opened) {
+			logFile = OpenLogFile(close);
+			opened = true;
+		}
+
+		if (slot.longLine) {
+			WriteLogLine(logFile, slot.longLine, slot.length);
+			free(slot.longLine);
+			slot.longLine = nullptr;
+		} else {
+			WriteLogLine(logFile, slot.line, slot.length);
+		}
+
+		slot.sequence.store(logRingDequeuePos + LOG_RING_SIZE, std::memory_order_release);
+		logRingDequeuePos++;
+	}
+
+	if (opened) {
+		if (close)
+			fclose(logFile);
+		else if (logFile)
+			fflush(logFile);
+		fflush(stdout);
+	}
+}
+
+static void LogWriterThread()
+{
+	pthread_setname_np(pthread_self(), "FPP-LogWriter");
+
+	while (logWriterRunning) {
+		DrainLogRing();
+
+		std::unique_lock<std::mutex> lock(*logWriterLock);
+		logWriterIdle = true;
+		// producers only signal when we're idle, the timeout covers a
+		// signal that races with going idle
+		logWriterCV->wait_for(lock, std::chrono::milliseconds(100));
+		logWriterIdle = false;
+	}
+
+	DrainLogRing();
+}
+
+static void StopLogWriter()
+{
+	if (logWriterState != LOG_WRITER_RUNNING)
+		return;
+
+	// anything logged from here on is written directly
+	logWriterState = LOG_WRITER_SYNC;
+	logWriterRunning = false;
+	logWriterCV->notify_one();
+	logWriterThread->join();
+	delete logWriterThread;
+	logWriterThread = nullptr;
+}
+
+static void LogWriterAfterFork()
+{
+	// the writer thread does not exist in the child
+	logWriterState = LOG_WRITER_SYNC;
+}
+
+static bool StartLogWriter()
+{
+	int state = LOG_WRITER_NOT_STARTED;
+	if (!logWriterState.compare_exchange_strong(state, LOG_WRITER_STARTING))
+		return state == LOG_WRITER_RUNNING;
+
+	for (uint32_t i = 0; i < LOG_RING_SIZE; i++) {
+		logRing[i].sequence.store(i, std::memory_order_relaxed);
+		logRing[i].longLine = nullptr;
+	}
+
+	logWriterLock = new std::mutex();
+	logWriterCV = new std::condition_variable();
+	logWriterRunning = true;
+	logWriterThread = new std::thread(LogWriterThread);
+
+	static bool registered = false;
+	if (!registered) {
+		pthread_atfork(nullptr, nullptr, LogWriterAfterFork);
+		atexit(StopLogWriter);
+		registered = true;
+	}
+
+	logWriterState = LOG_WRITER_RUNNING;
+	return true;
+}
+
+void RestartLogWriter(void)
+{
+	if ((logWriterState != LOG_WRITER_SYNC) || !logWriterThread)
+		return;
+
+	// The thread object belongs to the parent's writer, it can't be
+	// joined or deleted here.  Anything still queued was the parent's to
+	// write so start over with an empty ring.
+	logWriterThread = nullptr;
+	logRingEnqueuePos = 0;
+	logRingDequeuePos = 0;
+	logWriterState = LOG_WRITER_NOT_STARTED;
+}
+
+/*
+ * Format the line into the next free ring slot.  Returns false if the
+ * writer thread isn't available and the caller needs to write the line
+ * itself.
+ */
+static bool QueueLogLine(const char *format, va_list arg)
+{
+	if ((logWriterState != LOG_WRITER_RUNNING) && !StartLogWriter())
+		return false;
+
+	uint32_t pos = logRingEnqueuePos.load(std::memory_order_relaxed);
+	LogRingSlot *slot;
+	while (true) {
+		slot = &logRing[pos & (LOG_RING_SIZE - 1)];
+		int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (logRingEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			logRingDropped++;
+			return true;
+		} else {
+			pos = logRingEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	va_list arg2;
+	va_copy(arg2, arg);
+	int len = vsnprintf(slot->line, LOG_RING_LINE_SIZE, format, arg);
+	if (len >= LOG_RING_LINE_SIZE) {
+		slot->longLine = (char *)malloc(len + 1);
+		if (slot->longLine)
+			vsnprintf(slot->longLine, len + 1, format, arg2);
+		else
+			len = LOG_RING_LINE_SIZE - 1;
+	}
+	va_end(arg2);
+	slot->length = len < 0 ? 0 : len;
+
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	if (logWriterIdle)
+		logWriterCV->notify_one();
+
+	return true;
+}
+
 void _LogWrite(const char *file, int line, int level, FPPLoggerInstance &facility, const char *format, ...)
 {
 	// Don't log if we're not concerned about anything at this level
@@ -209,40 +460,38 @@ void _LogWrite(const char *file, int line, int level, FPPLoggerInstance &facilit
                     ms,
                     syscall(SYS_gettid), facility.name.c_str(), file, line, format);
 
-	if (logFileName[0]) {
-		FILE *logFile;
-
-        bool close = true;
-		if (!strcmp(logFileName, "stderr")) {
-			logFile = stderr;
-            close = false;
-		} else if (!strcmp(logFileName, "stdout")) {
-			logFile = stdout;
-            close = false;
-        } else {
-			logFile = fopen(logFileName, "a");
-			if ( ! logFile ) {
-				fprintf(stderr, "Error: Unable to open log file for writing!\n");
-				va_start(arg, format);
-				vfprintf(stderr, timeStr, arg);
-				va_end(arg);
-				return;
-			}
-		}
-
-		va_start(arg, format);
-		vfprintf(logFile, timeStr, arg);
-		va_end(arg);
+	va_start(arg, format);
+	bool queued = QueueLogLine(timeStr, arg);
+	va_end(arg);
+	if (queued)
+		return;
 
-        if (close)  {
-			fclose(logFile);
-        }
-	}
-    if (strcmp(logFileName, "stdout") && logToStdOut) {
-		va_start(arg, format);
-		vfprintf(stdout, timeStr, arg);
-		va_end(arg);
+	char buf[4096];
+	char *out = buf;
+	va_start(arg, format);
+	int len = vsnprintf(buf, sizeof(buf), timeStr, arg);
+	va_end(arg);
+	if (len < 0)
+		return;
+	if (len >= (int)sizeof(buf)) {
+		out = (char *)malloc(len + 1);
+		if (out) {
+			va_start(arg, format);
+			vsnprintf(out, len + 1, timeStr, arg);
+			va_end(arg);
+		} else {
+			out = buf;
+			len = sizeof(buf) - 1;
+		}
 	}
+
+	bool close = false;
+	FILE *logFile = OpenLogFile(close);
+	WriteLogLine(logFile, out, len);
+	if (close)
+		fclose(logFile);
+	if (out != buf)
+		free(out);
 }
 
 void SetLogFile(const char *filename, bool toStdOut)
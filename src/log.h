@@ -123,6 +123,12 @@ void _LogWrite(const char *file, int line, int level, FPPLoggerInstance &facilit
 bool WillLog(int level, FPPLoggerInstance &facility);
 
 void SetLogFile(const char *filename, bool toStdOut = true);
+
+// Log messages are written by a background thread which does not survive
+// fork().  A forked child writes directly to the log unless it calls
+// this, which a long running child such as the daemonized fppd should do
+// while it is still single threaded.
+void RestartLogWriter(void);
 int loggingToFile(void);
 void logVersionInfo(void);
 
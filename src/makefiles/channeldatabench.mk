@@ -0,0 +1,14 @@
+# Micro-benchmark for the channel data compare/copy kernels, not built by
+# default.  Run "make channeldatabench && ./channeldatabench"
+OBJECTS_channeldatabench = \
+    util/ChannelDataCompare.o \
+    util/ChannelDataCompareNEON.o \
+    util/ChannelDataCompareBench.o
+
+OBJECTS_ALL+=$(OBJECTS_channeldatabench)
+
+channeldatabench: $(OBJECTS_channeldatabench)
+	$(CCACHE) $(CC) $(CFLAGS_$@) $(OBJECTS_$@) $(LIBS_$@) $(LDFLAGS) $(LDFLAGS_$@) -o $@
+
+clean::
+	rm -f channeldatabench
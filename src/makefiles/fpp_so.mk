@@ -6,6 +6,9 @@ OBJECTS_fpp_so += \
 	channeloutput/channeloutput.o \
 	channeloutput/channeloutputthread.o \
 	channeloutput/ColorOrder.o \
+	channeloutput/DirtyChannelRanges.o \
+	channeloutput/FrameTiming.o \
+	channeloutput/MasterFrameClock.o \
 	channeloutput/FPD.o \
 	channeloutput/Matrix.o \
 	channeloutput/PanelMatrix.o \
@@ -53,7 +56,9 @@ OBJECTS_fpp_so += \
 	ping.o \
 	Player.o \
 	overlays/PixelOverlay.o \
+    overlays/PixelOverlayBlend.o \
     overlays/PixelOverlayEffects.o \
+    overlays/PixelOverlayFont.o \
 	overlays/PixelOverlayModel.o \
     overlays/WLEDEffects.o \
     overlays/wled/FX.o \
@@ -89,10 +94,13 @@ OBJECTS_fpp_so += \
 	settings.o \
 	sunset.o \
 	Warnings.o \
+    util/ChannelDataCompare.o \
+    util/ChannelDataCompareNEON.o \
     util/GPIOUtils.o \
     util/I2CUtils.o \
     util/SPIUtils.o \
     util/tinyexpr.o \
+    util/WorkerPool.o \
     util/ExpressionProcessor.o \
     $(OBJECTS_GPIO_ADDITIONS)
 
@@ -106,6 +114,7 @@ LIBS_fpp_so += \
 	-lhttpserver \
 	-ljsoncpp \
 	-lm \
+	-lfreetype \
 	-lmosquitto \
 	-lutil \
 	-ltag \
@@ -121,6 +130,13 @@ LIBS_fpp_so += \
 
 
 CFLAGS_mediaoutput/mediaoutput.o+=-DHASVLC
+CXXFLAGS_overlays/PixelOverlayFont.o+=$(shell pkg-config --cflags freetype2)
+
+# 32bit ARM builds default to an ARMv6/VFP baseline, the NEON kernel is only
+# used after checking HWCAP_NEON at runtime
+ifneq ($(findstring arm-,$(shell $(CXXCOMPILER) -dumpmachine)),)
+CXXFLAGS_util/ChannelDataCompareNEON.o+=-march=armv7-a -mfpu=neon
+endif
 
 
 util/tinyexpr.o: util/tinyexpr.c fppversion_defines.h Makefile makefiles/*.mk makefiles/platform/*.mk
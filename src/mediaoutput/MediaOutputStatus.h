@@ -34,4 +34,7 @@ typedef struct mediaOutputStatus {
 	int minutesTotal;
 	int secondsTotal;
 	float mediaSeconds;
+	unsigned int videoFramesDecoded;
+	unsigned int videoFramesDropped; // decoded but never displayed
+	unsigned int videoFramesLate;    // decoded after their display time
 } MediaOutputStatus; 
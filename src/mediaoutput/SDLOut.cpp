@@ -50,6 +50,9 @@ extern "C"
 
 //Only keep 30 frames in buffer
 #define VIDEO_FRAME_MAX     30
+//a single packet can decode to more than one frame so the ring
+//has a few extra slots beyond the point we stop reading
+#define VIDEO_FRAME_SLOTS   (VIDEO_FRAME_MAX + 4)
 
 #if defined(PLATFORM_PI)
 //on the old single core Pi's, we need to increase the buffer size
@@ -64,9 +67,7 @@ static bool AudioHasStalled = false;
 
 class VideoFrame {
 public:
-    VideoFrame(int ms,  uint8_t *d, int s) : data(d), timestamp(ms), size(s) {
-        next = nullptr;
-    }
+    VideoFrame() : timestamp(0), size(0), data(nullptr) {}
     ~VideoFrame() {
         free(data);
     }
@@ -74,7 +75,6 @@ public:
     int timestamp;
     int size;
     uint8_t *data;
-    VideoFrame *next;
 };
 
 
@@ -102,13 +102,25 @@ public:
         videoStream = audioStream = nullptr;
         doneRead = false;
         frame = av_frame_alloc();
-        scaledFrame = nullptr;
+        videoFormatContext = nullptr;
+        videoFrame = nullptr;
+        videoDecodeThread = nullptr;
+        videoDecodeRunning = false;
+        videoDoneRead = false;
+        videoSkipToMS = 0;
+        videoFrameMS = 0;
         au_convert_ctx = nullptr;
         decodedDataLen = 0;
         swsCtx = nullptr;
-        firstVideoFrame = lastVideoFrame = nullptr;
-        curVideoFrame = nullptr;
+        videoFrameHead = 0;
+        videoFrameTail = 0;
+        curVideoFrame = -1;
         videoFrameCount = 0;
+        videoFramesDecoded = 0;
+        videoFramesDropped = 0;
+        videoFramesLate = 0;
+        lastVideoTimestamp = -1;
+        lastVideoTimestampTime = 0;
         audioDev = 0;
         outBufferPos = 0;
         currentRate = rate;
@@ -120,25 +132,27 @@ public:
         outBuffer = new uint8_t[maxQueueSize];
     }
     ~SDLInternalData() {
+        stopVideoDecode();
         if (frame != nullptr) {
             av_free(frame);
         }
+        if (videoFrame != nullptr) {
+            av_free(videoFrame);
+        }
+        if (videoCodecContext != nullptr) {
+            //also stops the frame threads
+            avcodec_free_context(&videoCodecContext);
+        }
+        if (audioCodecContext != nullptr) {
+            avcodec_free_context(&audioCodecContext);
+        }
+        if (videoFormatContext != nullptr) {
+            avformat_close_input(&videoFormatContext);
+        }
         if (swsCtx != nullptr) {
             sws_freeContext(swsCtx);
             swsCtx = nullptr;
         }
-        while (firstVideoFrame) {
-            VideoFrame *t = firstVideoFrame;
-            firstVideoFrame = t->next;
-            delete t;
-        }
-        if (scaledFrame != nullptr) {
-            if (scaledFrame->data[0] != nullptr) {
-                av_free(scaledFrame->data[0]);
-            }
-
-            av_free(scaledFrame);
-        }
         if (formatContext != nullptr) {
             avformat_close_input(&formatContext);
         }
@@ -172,18 +186,39 @@ public:
     int minQueueSize;
     int maxQueueSize;
 
-    // stuff for the video stream
+    // stuff for the video stream, decoded on its own thread from its
+    // own demuxer so video decode can never starve the audio queue
+    AVFormatContext *videoFormatContext;
+    AVPacket videoPacket;
+    AVFrame *videoFrame;
+    std::thread *videoDecodeThread;
+    std::atomic_bool videoDecodeRunning;
+    volatile bool videoDoneRead;
+    int videoSkipToMS;
+    int videoFrameMS;
     AVCodecContext *videoCodecContext;
     int video_stream_idx = -1;
     AVStream* videoStream;
     int video_dtspersec;
     int video_frames;
-    AVFrame* scaledFrame;
     SwsContext *swsCtx;
-    VideoFrame *firstVideoFrame;
-    VideoFrame *lastVideoFrame;
-    volatile VideoFrame * volatile curVideoFrame;
-    int videoFrameCount;
+    int videoFrameLineSize;
+
+    // Ring of preallocated frame slots.  Head, tail and cur are frame
+    // counters, the slot is the counter % VIDEO_FRAME_SLOTS.  The decode
+    // thread writes at tail and releases everything before cur, the
+    // channel output thread only moves cur forward within [head, tail)
+    VideoFrame videoFrames[VIDEO_FRAME_SLOTS];
+    std::atomic_int videoFrameHead;
+    std::atomic_int videoFrameTail;
+    std::atomic_int curVideoFrame;
+    std::atomic_int videoFrameCount;
+    std::atomic_int lastVideoTimestamp;
+    std::atomic<long long> lastVideoTimestampTime;
+
+    std::atomic_uint videoFramesDecoded;
+    std::atomic_uint videoFramesDropped;
+    std::atomic_uint videoFramesLate;
     unsigned int totalVideoLen;
     long long videoStartTime;
     PixelOverlayModel *videoOverlayModel = nullptr;
@@ -193,42 +228,185 @@ public:
     unsigned int curPos;
     std::mutex curPosLock;
     
-    void addVideoFrame(int ms, uint8_t *d, int sz) {
-        VideoFrame *f = new VideoFrame(ms, d, sz);
-        if (firstVideoFrame == nullptr) {
-            curVideoFrame = f;
-            firstVideoFrame = f;
-            lastVideoFrame = f;
-        } else {
-            lastVideoFrame->next = f;
-            lastVideoFrame = f;
+    void initVideoFrames(int width, int height) {
+        videoFrameLineSize = width * 3;
+        for (auto &f : videoFrames) {
+            f.size = videoFrameLineSize * height;
+            f.data = (uint8_t*)calloc(1, f.size);
+        }
+    }
+    // returns the slot to decode the next frame into or nullptr if the
+    // ring is full, call commitVideoFrame once the data is filled in
+    VideoFrame *nextVideoFrameSlot() {
+        int tail = videoFrameTail;
+        if ((tail - videoFrameHead) >= VIDEO_FRAME_SLOTS) {
+            ++videoFramesDropped;
+            return nullptr;
         }
+        return &videoFrames[tail % VIDEO_FRAME_SLOTS];
+    }
+    void commitVideoFrame(VideoFrame *f, int ms) {
+        f->timestamp = ms;
+        int tail = videoFrameTail;
+        if (curVideoFrame < 0) {
+            curVideoFrame = tail;
+        }
+        videoFrameTail = tail + 1;
         ++videoFrameCount;
     }
-    
-    int buffersFull(bool flushaudio) {
-        int retVal = -1;
-        if (video_stream_idx != -1) {
-            //if video
-            while (firstVideoFrame && (firstVideoFrame != curVideoFrame)) {
-                videoFrameCount--;
-                auto tmp = firstVideoFrame->next;
-                delete firstVideoFrame;
-                firstVideoFrame = tmp;
+    // release all the frames before the current frame so the slots can be reused
+    void releaseVideoFrames() {
+        int cur = curVideoFrame;
+        if (cur < 0) {
+            cur = videoFrameTail;
+        }
+        int head = videoFrameHead;
+        if (cur > head) {
+            videoFrameHead = cur;
+            videoFrameCount -= (cur - head);
+        }
+    }
+    // find the last decoded frame with a timestamp at or before ms,
+    // frames between the current frame and that one are never displayed
+    VideoFrame *findVideoFrame(unsigned int ms) {
+        int cur = curVideoFrame;
+        if (cur < 0) {
+            return nullptr;
+        }
+        int tail = videoFrameTail;
+        int lo = cur;
+        int hi = tail - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (videoFrames[mid % VIDEO_FRAME_SLOTS].timestamp <= (int)ms) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
             }
-            retVal = (doneRead || (videoFrameCount >= VIDEO_FRAME_MAX)) ? 2
-                : ((videoFrameCount >= (VIDEO_FRAME_MAX - 6)) ? 1 : 0);
-            if (!flushaudio) {
-                return retVal;
+        }
+        if (lo > cur) {
+            videoFramesDropped += (lo - cur - 1);
+            curVideoFrame = lo;
+        }
+        lastVideoTimestampTime = GetTimeMS();
+        lastVideoTimestamp = ms;
+        return &videoFrames[lo % VIDEO_FRAME_SLOTS];
+    }
+    // the media position the channel output thread is currently
+    // displaying, extrapolated from the last frame it asked for
+    int videoClockMS() {
+        int ms = lastVideoTimestamp;
+        if (ms < 0) {
+            return videoSkipToMS;
+        }
+        return ms + (int)(GetTimeMS() - lastVideoTimestampTime);
+    }
+
+    // receive the next frame from the video decoder, feeding it packets
+    // as needed, returns false once everything has been decoded
+    bool decodeNextVideoFrame() {
+        while (true) {
+            int ret = avcodec_receive_frame(videoCodecContext, videoFrame);
+            if (ret == 0) {
+                return true;
+            } else if (ret != AVERROR(EAGAIN)) {
+                return false;
+            }
+            if (av_read_frame(videoFormatContext, &videoPacket) == 0) {
+                if (videoPacket.stream_index == video_stream_idx) {
+                    avcodec_send_packet(videoCodecContext, &videoPacket);
+                }
+                av_packet_unref(&videoPacket);
+            } else if (avcodec_send_packet(videoCodecContext, nullptr)) {
+                // already flushed, the frame threads are drained
+                return false;
             }
         }
+    }
+    // decode frames until the ring is full, returns the number of frames added
+    int fillVideoFrames() {
+        int count = 0;
+        releaseVideoFrames();
+        while (!videoDoneRead && videoFrameCount < VIDEO_FRAME_MAX) {
+            if (!decodeNextVideoFrame()) {
+                videoDoneRead = true;
+                break;
+            }
+            int ms = DTStoMS(videoFrame->pkt_dts, video_dtspersec);
+            if (ms < videoSkipToMS) {
+                //before the start position
+                av_frame_unref(videoFrame);
+                continue;
+            }
+            ++videoFramesDecoded;
+            if ((ms + videoFrameMS) <= videoClockMS()) {
+                //the next frame is already due, don't waste time scaling this one
+                ++videoFramesLate;
+                ++videoFramesDropped;
+                av_frame_unref(videoFrame);
+                continue;
+            }
+            VideoFrame *vf = nextVideoFrameSlot();
+            if (vf == nullptr) {
+                //ring is full, nowhere to put it
+            } else if (swsCtx) {
+                uint8_t *dstData[4] = { vf->data, nullptr, nullptr, nullptr };
+                int dstLineSize[4] = { videoFrameLineSize, 0, 0, 0 };
+                sws_scale(swsCtx, videoFrame->data, videoFrame->linesize, 0,
+                          videoCodecContext->height, dstData, dstLineSize);
+                commitVideoFrame(vf, ms);
+                count++;
+            } else {
+                int sz = std::min(videoFrame->linesize[0] * videoFrame->height, vf->size);
+                memcpy(vf->data, videoFrame->data[0], sz);
+                commitVideoFrame(vf, ms);
+                count++;
+            }
+            av_frame_unref(videoFrame);
+        }
+        return count;
+    }
+    static void videoDecodeThreadEntry(SDLInternalData *d) {
+        d->runVideoDecode();
+    }
+    void runVideoDecode() {
+        while (videoDecodeRunning && !videoDoneRead) {
+            if (fillVideoFrames() == 0) {
+                //ring is full, wait for the output to consume some frames
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::max(videoFrameMS / 2, 5)));
+            }
+        }
+        videoDecodeRunning = false;
+    }
+    void startVideoDecode(int msTime) {
+        if (video_stream_idx == -1 || videoDecodeThread) {
+            return;
+        }
+        videoSkipToMS = msTime;
+        // have the first frame ready before the output starts asking for it
+        while (!videoDoneRead && videoFrameCount == 0) {
+            fillVideoFrames();
+        }
+        videoDecodeRunning = true;
+        videoDecodeThread = new std::thread(videoDecodeThreadEntry, this);
+    }
+    void stopVideoDecode() {
+        if (videoDecodeThread) {
+            videoDecodeRunning = false;
+            videoDecodeThread->join();
+            delete videoDecodeThread;
+            videoDecodeThread = nullptr;
+        }
+    }
+    
+    int buffersFull() {
         if (audioDev == 0) {
             //no audio device, clear the audio buffer
             curPosLock.lock();
             curPos += outBufferPos;
             outBufferPos = 0;
             curPosLock.unlock();
-            return retVal >= 0 ? retVal : 2;
+            return 2;
         }
         unsigned int queue = SDL_GetQueuedAudioSize(audioDev);
         //if we have data and are either below the queue threshold or we've finished reading
@@ -240,9 +418,6 @@ public:
             curPosLock.unlock();
             queue = SDL_GetQueuedAudioSize(audioDev);
         }
-        if (retVal >= 0) {
-            return retVal;
-        }
         if (doneRead) {
             //done reading, they are as full as they will get
             return 2;
@@ -256,14 +431,18 @@ public:
         return 2;
     }
     int maybeFillBuffer(bool first) {
-        if (doneRead || videoFrameCount > VIDEO_FRAME_MAX) {
+        if (doneRead) {
             //buffers are full, don't so anything
             if (AudioHasStalled) LogWarn(VB_MEDIAOUT, "Stalled audio, buffers are full.  %d\n", doneRead);
             return 0;
         }
+        if (audio_stream_idx == -1) {
+            //video only, the video decode thread does all the reading
+            doneRead = true;
+            return 0;
+        }
         if (AudioHasStalled) LogWarn(VB_MEDIAOUT, "Stalled audio, buffers still filling.\n");
         int orig = outBufferPos;
-        bool vidPacket = false;
         while (av_read_frame(formatContext, &readingPacket) == 0) {
             bool packetOk = false;
             if (readingPacket.stream_index == audio_stream_idx) {
@@ -303,41 +482,14 @@ public:
                     }
                 }
                 packetOk = true;
-            } else if (readingPacket.stream_index == video_stream_idx) {
-                while (avcodec_send_packet(videoCodecContext, &readingPacket)) {
-                    while (!avcodec_receive_frame(videoCodecContext, frame)) {
-                        int ms = DTStoMS(frame->pkt_dts, video_dtspersec);
-                       
-                        if (swsCtx) {
-                            sws_scale(swsCtx, frame->data, frame->linesize, 0,
-                                      videoCodecContext->height, scaledFrame->data,
-                                      scaledFrame->linesize);
-                        
-                            int sz = scaledFrame->linesize[0] * scaledFrame->height;
-                            uint8_t *d = (uint8_t*)malloc(sz);
-                            memcpy(d, scaledFrame->data[0], sz);
-                            addVideoFrame(ms, d, sz);
-                        } else {
-                            int sz = frame->linesize[0] * frame->height;
-                            uint8_t *d = (uint8_t*)malloc(sz);
-                            memcpy(d, frame->data[0], sz);
-                            addVideoFrame(ms, d, sz);
-                        }
-                        vidPacket = true;
-                        av_frame_unref(frame);
-                    }
-                }
-                packetOk = true;
             }
             av_packet_unref(&readingPacket);
             
             if (packetOk) {
                 if (first) {
-                    if ((outBufferPos > minQueueSize || videoFrameCount > VIDEO_FRAME_MAX))  {
+                    if (outBufferPos > minQueueSize)  {
                         return outBufferPos - orig;
                     }
-                } else if (video_stream_idx != -1 && !vidPacket) {
-                    //didn't get a video packet, we'll keep going
                 } else {
                     return outBufferPos - orig;
                 }
@@ -385,6 +537,11 @@ static int open_codec_context(int *stream_idx,
                     av_get_media_type_string(type));
             return ret;
         }
+        if (type == AVMEDIA_TYPE_VIDEO) {
+            // let libavcodec pick the thread count for frame threading
+            (*dec_ctx)->thread_count = 0;
+            (*dec_ctx)->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        }
         /* Init the decoders, with or without reference counting */
         av_dict_set(&opts, "refcounted_frames", "0", 0);
         if ((ret = avcodec_open2(*dec_ctx, dec, &opts)) < 0) {
@@ -450,24 +607,10 @@ public:
                     memcpy(d->outBuffer, &d->outBuffer[c], d->outBufferPos-c);
                     d->outBufferPos -= c;
                     d->maybeFillBuffer(false);
-                    
-                    while (d->firstVideoFrame && d->firstVideoFrame->timestamp < msTime) {
-                        VideoFrame *t = d->firstVideoFrame;
-                        d->firstVideoFrame = t->next;
-                        delete t;
-                    }
-                    d->curVideoFrame = d->firstVideoFrame;
-                    d->maybeFillBuffer(false);
                 } else {
                     //need to skip the entire chunk, just wipe it out
                     d->curPos += d->outBufferPos;
                     d->outBufferPos = 0;
-                    while (d->firstVideoFrame) {
-                        VideoFrame *t = d->firstVideoFrame;
-                        d->firstVideoFrame = t->next;
-                        delete t;
-                    }
-                    d->curVideoFrame = nullptr;
                     d->maybeFillBuffer(false);
                 }
             }
@@ -555,13 +698,13 @@ void SDL::runDecode() {
             decoding = false;
             std::this_thread::sleep_for(std::chrono::milliseconds(250));
         } else {
-            int bufFull = data->buffersFull(true);
+            int bufFull = data->buffersFull();
             bool bufFillWas0 = false;
             int count = 0;
             while (bufFull == 0 && count < 5) {
                 //critical, the SDL queue is < max
                 data->maybeFillBuffer(false);
-                bufFull = data->buffersFull(false);
+                bufFull = data->buffersFull();
                 bufFillWas0 = true;
                 count++;
             }
@@ -580,20 +723,15 @@ void SDL::runDecode() {
                         // read a 1/10 of a second, move on
                         bufFull = 2;
                     } else {
-                        bufFull = data->buffersFull(false);
+                        bufFull = data->buffersFull();
                     }
                 }
             }
-            if (data->video_stream_idx != -1 && data->videoFrameCount < 15) {
-                //we won't sleep, need to keep decoding
-                decoding = false;
+            decoding = false;
+            if (bufFillWas0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
             } else {
-                decoding = false;
-                if (bufFillWas0) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                } else {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(25));
-                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(25));
             }
         }
     }
@@ -727,13 +865,9 @@ bool SDLOutput::IsOverlayingVideo() {
 }
 bool SDLOutput::ProcessVideoOverlay(unsigned int msTimestamp) {
     SDLInternalData *data = sdlManager.data;
-    if (data && !data->stopped && data->video_stream_idx != -1 && data->curVideoFrame && data->videoOverlayModel) {
-        while (data->curVideoFrame->next
-               && data->curVideoFrame->next->timestamp <= msTimestamp) {
-            data->curVideoFrame = data->curVideoFrame->next;
-        }
-        if (msTimestamp <= data->totalVideoLen) {
-            VideoFrame *vf = (VideoFrame*)data->curVideoFrame;
+    if (data && !data->stopped && data->video_stream_idx != -1 && data->videoOverlayModel) {
+        VideoFrame *vf = data->findVideoFrame(msTimestamp);
+        if (vf && msTimestamp <= data->totalVideoLen) {
             
             long long t = GetTime() / 1000;
             int t2 = ((int)t) - data->videoStartTime;
@@ -798,6 +932,9 @@ SDLOutput::SDLOutput(const std::string &mediaFilename,
     m_mediaOutputStatus->mediaSeconds = 0.0;
     m_mediaOutputStatus->secondsElapsed = 0;
     m_mediaOutputStatus->subSecondsElapsed = 0;
+    m_mediaOutputStatus->videoFramesDecoded = 0;
+    m_mediaOutputStatus->videoFramesDropped = 0;
+    m_mediaOutputStatus->videoFramesLate = 0;
     
     if (sdlManager.blacklisted.find(mediaFilename) != sdlManager.blacklisted.end()) {
         currentMediaFilename = "";
@@ -860,10 +997,23 @@ SDLOutput::SDLOutput(const std::string &mediaFilename,
     if (videoOutput != "--Disabled--" && videoOutput != "" && (videoOutput != "--HDMI--" && videoOutput != "HDMI")) {
         data->videoOverlayModel = PixelOverlayManager::INSTANCE.getModel(videoOutput);
         
-        if (data->videoOverlayModel &&
-            open_codec_context(&data->video_stream_idx, &data->videoCodecContext, data->formatContext, AVMEDIA_TYPE_VIDEO, fullAudioPath.c_str()) >= 0) {
+        if (data->videoOverlayModel
+            && avformat_open_input(&data->videoFormatContext, fullAudioPath.c_str(), nullptr, nullptr) == 0
+            && avformat_find_stream_info(data->videoFormatContext, nullptr) >= 0
+            && open_codec_context(&data->video_stream_idx, &data->videoCodecContext, data->videoFormatContext, AVMEDIA_TYPE_VIDEO, fullAudioPath.c_str()) >= 0) {
             data->videoOverlayModel->getSize(videoOverlayWidth, videoOverlayHeight);
-            data->videoStream = data->formatContext->streams[data->video_stream_idx];
+            data->videoStream = data->videoFormatContext->streams[data->video_stream_idx];
+            data->videoFrame = av_frame_alloc();
+
+            // each demuxer only returns the packets its decoder needs
+            for (unsigned int x = 0; x < data->videoFormatContext->nb_streams; x++) {
+                if (x != (unsigned int)data->video_stream_idx) {
+                    data->videoFormatContext->streams[x]->discard = AVDISCARD_ALL;
+                }
+            }
+            if ((unsigned int)data->video_stream_idx < data->formatContext->nb_streams) {
+                data->formatContext->streams[data->video_stream_idx]->discard = AVDISCARD_ALL;
+            }
         } else {
             data->videoStream = nullptr;
             data->video_stream_idx = -1;
@@ -919,19 +1069,15 @@ SDLOutput::SDLOutput(const std::string &mediaFilename,
         }
 
         data->totalVideoLen = lengthMS;
-        data->scaledFrame = av_frame_alloc();
-    
-    
-        data->scaledFrame->width = videoOverlayWidth;
-        data->scaledFrame->height = videoOverlayHeight;
-    
-        data->scaledFrame->linesize[0] = data->scaledFrame->width * 3;
-        data->scaledFrame->data[0] = (uint8_t *)av_malloc(data->scaledFrame->width * data->scaledFrame->height * 3 * sizeof(uint8_t));
+        if (data->videoStream->avg_frame_rate.num) {
+            data->videoFrameMS = 1000 * data->videoStream->avg_frame_rate.den / data->videoStream->avg_frame_rate.num;
+        }
+        data->initVideoFrames(videoOverlayWidth, videoOverlayHeight);
     
         data->swsCtx = sws_getContext(data->videoCodecContext->width,
                                       data->videoCodecContext->height,
                                       data->videoCodecContext->pix_fmt,
-                                      data->scaledFrame->width, data->scaledFrame->height,
+                                      videoOverlayWidth, videoOverlayHeight,
                                       AVPixelFormat::AV_PIX_FMT_RGB24, SWS_BICUBIC, nullptr,
                                       nullptr, nullptr);
     }
@@ -961,6 +1107,7 @@ int SDLOutput::Start(int msTime)
 	LogDebug(VB_MEDIAOUT, "SDLOutput::Start() %X\n", data);
     if (data) {
         SetChannelOutputFrameNumber(0);
+        data->startVideoDecode(msTime);
         if (!sdlManager.Start(data, msTime)) {
             if (noDeviceWarning) {
                 WarningHolder::AddWarning(noDeviceError);
@@ -1068,10 +1215,15 @@ int SDLOutput::Process(void)
         m_mediaOutputStatus->secondsRemaining = s;
         m_mediaOutputStatus->subSecondsRemaining = ss;
         
-        if (remaining < 0.0 && data->doneRead) {
+        if (remaining < 0.0 && data->videoDoneRead) {
             m_mediaOutputStatus->status = MEDIAOUTPUTSTATUS_IDLE;
         }
     }
+    if (data->video_stream_idx != -1) {
+        m_mediaOutputStatus->videoFramesDecoded = data->videoFramesDecoded;
+        m_mediaOutputStatus->videoFramesDropped = data->videoFramesDropped;
+        m_mediaOutputStatus->videoFramesLate = data->videoFramesLate;
+    }
     if (getFPPmode() == MASTER_MODE) {
         multiSync->SendMediaSyncPacket(m_mediaFilename,
                             m_mediaOutputStatus->mediaSeconds);
@@ -1098,6 +1250,13 @@ int  SDLOutput::Close(void)
     Stop();
     sdlManager.Close();
     
+    if (data && data->video_stream_idx != -1) {
+        LogDebug(VB_MEDIAOUT, "Video frames decoded: %u  dropped: %u  late: %u\n",
+                 (unsigned int)data->videoFramesDecoded,
+                 (unsigned int)data->videoFramesDropped,
+                 (unsigned int)data->videoFramesLate);
+    }
+    
     if (data && data->videoOverlayModel) {
         data->videoOverlayModel->clearOverlayBuffer();
         data->videoOverlayModel->flushOverlayBuffer();
@@ -33,10 +33,12 @@
 
 #include "effects.h"
 #include "channeloutput/channeloutputthread.h"
+#include "channeloutput/DirtyChannelRanges.h"
 
 #include "PixelOverlay.h"
 #include "PixelOverlayEffects.h"
 #include "PixelOverlayModel.h"
+#include "util/WorkerPool.h"
 
 PixelOverlayManager PixelOverlayManager::INSTANCE;
 
@@ -49,6 +51,15 @@ public:
     int value = 0;
 };
 
+// Immutable copy of the active models and ranges.  doOverlays runs on the
+// output thread every frame and reads this without taking any locks,
+// writers build a new one and swap it in with publishActiveSnapshot().
+class OverlaySnapshot {
+public:
+    std::vector<PixelOverlayModel*> models;
+    std::vector<OverlayRange> ranges;
+};
+
 uint32_t PixelOverlayManager::mapColor(const std::string &c) {
     if (c[0] == '#') {
         std::string color = "0x" + c.substr(1);
@@ -78,23 +89,21 @@ uint32_t PixelOverlayManager::mapColor(const std::string &c) {
 }
 
 
-PixelOverlayManager::PixelOverlayManager() : numActive(0) {
+PixelOverlayManager::PixelOverlayManager()
+    : numActive(0), activeSnapshot(new OverlaySnapshot()), snapshotReaders(0), hasAfterOverlayModels(false) {
 }
 PixelOverlayManager::~PixelOverlayManager() {
-    if (updateThread != nullptr) {
-        std::unique_lock<std::mutex> l(threadLock);
-        threadKeepRunning = false;
-        l.unlock();
-        threadCV.notify_all();
-        updateThread->join();
-        delete updateThread;
-        updateThread = nullptr;
+    stopOverlayModelEffects();
+    if (effectWorkers != nullptr) {
+        delete effectWorkers;
+        effectWorkers = nullptr;
     }
     for (auto a : models) {
         delete a.second;
     }
     models.clear();
     modelNames.clear();
+    delete activeSnapshot.exchange(nullptr);
 }
 void PixelOverlayManager::Initialize() {
     loadModelMap();
@@ -103,15 +112,14 @@ void PixelOverlayManager::Initialize() {
 
 void PixelOverlayManager::loadModelMap() {
     LogDebug(VB_CHANNELOUT, "PixelOverlayManager::loadModelMap()\n");
-    if (updateThread != nullptr) {
-        std::unique_lock<std::mutex> l(threadLock);
-        threadKeepRunning = false;
-        updates.clear();
-        l.unlock();
-        threadCV.notify_all();
-        updateThread->join();
-        delete updateThread;
-        updateThread = nullptr;
+    stopOverlayModelEffects();
+    {
+        // make sure the output thread is done with the models before
+        // they are deleted
+        std::unique_lock<std::mutex> lock(activeModelsLock);
+        numActive -= activeModels.size();
+        activeModels.clear();
+        publishActiveSnapshot();
     }
     for (auto a : models) {
         delete a.second;
@@ -226,44 +234,86 @@ bool PixelOverlayManager::hasActiveOverlays() {
     return numActive > 0;
 }
 
+// Must be called with activeModelsLock held.  Publishes a new snapshot of
+// the active lists and waits for the output thread to be done with the
+// previous one before deleting it.
+void PixelOverlayManager::publishActiveSnapshot() {
+    OverlaySnapshot *snapshot = new OverlaySnapshot();
+    snapshot->models.assign(activeModels.begin(), activeModels.end());
+    snapshot->ranges.assign(activeRanges.begin(), activeRanges.end());
+    OverlaySnapshot *old = activeSnapshot.exchange(snapshot);
+    // Any reader that starts after the exchange sees the new snapshot, so
+    // once the count drops to zero nothing can still be using the old one
+    while (snapshotReaders > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    delete old;
+}
+
 void PixelOverlayManager::modelStateChanged(PixelOverlayModel *m, const PixelOverlayState &old, const PixelOverlayState &state) {
     if (old.getState() == 0) {
         //enabling, add
         std::unique_lock<std::mutex> lock(activeModelsLock);
         activeModels.push_back(m);
         numActive++;
+        publishActiveSnapshot();
     } else if (state.getState() == 0) {
         //disabling, remove
         std::unique_lock<std::mutex> lock(activeModelsLock);
         activeModels.remove(m);
         numActive--;
+        publishActiveSnapshot();
     }
     if (numActive > 0) {
         StartChannelOutputThread();
     }
 }
 
-void PixelOverlayManager::doOverlays(uint8_t *channels) {
+const OverlaySnapshot *PixelOverlayManager::acquireActiveSnapshot() {
     if (numActive == 0) {
+        return nullptr;
+    }
+    snapshotReaders++;
+    const OverlaySnapshot *snapshot = activeSnapshot;
+    if (snapshot->models.empty() && snapshot->ranges.empty()) {
+        snapshotReaders--;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+void PixelOverlayManager::doOverlays(uint8_t *channels, DirtyChannelRanges *modified) {
+    doOverlays(acquireActiveSnapshot(), channels, modified);
+}
+
+void PixelOverlayManager::doOverlays(const OverlaySnapshot *snapshot, uint8_t *channels, DirtyChannelRanges *modified) {
+    if (snapshot == nullptr) {
         return;
     }
-    std::unique_lock<std::mutex> lock(activeModelsLock);
-    for (auto m : activeModels) {
+    for (auto m : snapshot->models) {
         m->doOverlay(channels);
+        if (modified) {
+            modified->add(m->getStartChannel(), m->getChannelCount());
+        }
     }
-    for (auto &m: activeRanges) {
-        for (int s = m.start; s <= m.end; s++) {
-            channels[s] = m.value;
+    for (auto &m : snapshot->ranges) {
+        memset(&channels[m.start], m.value, m.end - m.start + 1);
+        if (modified) {
+            modified->add(m.start, m.end - m.start + 1);
         }
     }
-    lock.unlock();
-    std::unique_lock<std::mutex> l(threadLock);
-    while (!afterOverlayModels.empty()) {
-        PixelOverlayModel *m = afterOverlayModels.front();
-        afterOverlayModels.pop_front();
-        l.unlock();
-        m->updateRunningEffects();
-        l.lock();
+    snapshotReaders--;
+
+    if (hasAfterOverlayModels) {
+        std::unique_lock<std::mutex> l(threadLock);
+        while (!afterOverlayModels.empty()) {
+            PixelOverlayModel *m = afterOverlayModels.front();
+            afterOverlayModels.pop_front();
+            l.unlock();
+            m->updateRunningEffects();
+            l.lock();
+        }
+        hasAfterOverlayModels = false;
     }
 }
 
@@ -391,10 +441,12 @@ const std::shared_ptr<httpserver::http_response> PixelOverlayManager::render_GET
                 PixelOverlayModel *m = models[mn];
                 m->toJson(model);
                 model["isActive"] = (int)m->getState().getState();
+                model["opacity"] = m->getOpacity();
                 if (m->getRunningEffect()) {
                     model["effectName"] = m->getRunningEffect()->name();
                     model["isLocked"] = true;
                     model["effectRunning"] = true;
+                    m->getEffectStatsJson(model["effectStats"]);
                 } else {
                     model["effectRunning"] = false;
                 }
@@ -419,10 +471,12 @@ const std::shared_ptr<httpserver::http_response> PixelOverlayManager::render_GET
                 } else {
                     m->toJson(result);
                     result["isActive"] = (int)m->getState().getState();
+                    result["opacity"] = m->getOpacity();
                     if (m->getRunningEffect()) {
                         result["effectName"] = m->getRunningEffect()->name();
                         result["isLocked"] = true;
                         result["effectRunning"] = true;
+                        m->getEffectStatsJson(result["effectStats"]);
                     } else {
                         result["isLocked"] = false; //compatibility
                         result["effectRunning"] = false;
@@ -499,6 +553,9 @@ const std::shared_ptr<httpserver::http_response> PixelOverlayManager::render_PUT
                     Json::Value root;
                     if (LoadJsonFromString(req.get_content(), root)) {
                         if (root.isMember("State")) {
+                            if (root.isMember("Opacity")) {
+                                m->setOpacity(std::clamp(root["Opacity"].asInt(), 0, 255));
+                            }
                             m->setState(PixelOverlayState(root["State"].asInt()));
                             return std::shared_ptr<httpserver::http_response>(new httpserver::string_response("{ \"Status\": \"OK\", \"Message\": \"\"}", 200));
                         } else {
@@ -597,6 +654,7 @@ const std::shared_ptr<httpserver::http_response> PixelOverlayManager::render_PUT
                         int sz = activeRanges.size();
                         activeRanges.clear();
                         numActive -= sz;
+                        publishActiveSnapshot();
                         lock.unlock();
                         if (numActive == 0) {
                             numActive++;
@@ -648,6 +706,7 @@ const std::shared_ptr<httpserver::http_response> PixelOverlayManager::render_PUT
                         activeRanges.push_back(OverlayRange(start, end, val));
                         numActive++;
                     }
+                    publishActiveSnapshot();
                 }
                 //skip the ','
                 if (p3.size()) {
@@ -681,7 +740,7 @@ class EnableOverlayCommand : public OverlayCommand {
 public:
     EnableOverlayCommand(PixelOverlayManager *m) : OverlayCommand("Overlay Model State", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({"Disabled", "Enabled", "Transparent", "TransparentRGB"}));
+        args.push_back(CommandArg("State", "string", "State").setContentList({"Disabled", "Enabled", "Transparent", "TransparentRGB", "Additive", "Maximum", "Alpha"}));
     }
     
     virtual std::unique_ptr<Command::Result> run(const std::vector<std::string> &args) override {
@@ -734,7 +793,7 @@ class FillOverlayCommand : public OverlayCommand {
 public:
     FillOverlayCommand(PixelOverlayManager *m) : OverlayCommand("Overlay Model Fill", m) {
         args.push_back(CommandArg("Model", "multistring", "Model").setContentListUrl("api/models?simple=true", false));
-        args.push_back(CommandArg("State", "string", "State").setContentList({"Don't Set", "Enabled", "Transparent", "TransparentRGB"}));
+        args.push_back(CommandArg("State", "string", "State").setContentList({"Don't Set", "Enabled", "Transparent", "TransparentRGB", "Additive", "Maximum", "Alpha"}));
         args.push_back(CommandArg("Color", "color", "Color").setDefaultValue("#FF0000"));
     }
     
@@ -865,41 +924,63 @@ void PixelOverlayManager::doOverlayModelEffects() {
     std::unique_lock<std::mutex> l(threadLock);
     while (threadKeepRunning) {
         uint32_t waitTime = 1000;
-        if (!updates.empty()) {
-            uint64_t curTime = GetTimeMS();
-            while (!updates.empty() && updates.begin()->first <= curTime) {
-                std::list<PixelOverlayModel*> models = updates.begin()->second;
-                uint64_t startTime = updates.begin()->first;
-                updates.erase(updates.begin());
-                l.unlock();
-                
-                for (auto m : models) {
-                    int32_t ms = m->updateRunningEffects();
-                    if (ms != 0) {
-                        l.lock();
-                        if (ms > 0) {
-                            uint64_t t = startTime + ms;
-                            updates[t].push_back(m);
-                        } else {
-                            afterOverlayModels.push_back(m);
-                        }
-                        l.unlock();
-                    }
-                }
-                l.lock();
-                curTime = GetTimeMS();
-            }
-            if (!updates.empty()) {
-                waitTime = updates.begin()->first - curTime;
+        uint64_t curTime = GetTimeMS();
+        while (!updates.empty() && updates.begin()->first <= curTime) {
+            uint64_t startTime = updates.begin()->first;
+            for (auto m : updates.begin()->second) {
+                effectWorkers->submit([this, m, startTime]() {
+                    updateModelEffect(m, startTime);
+                });
             }
+            updates.erase(updates.begin());
+        }
+        if (!updates.empty()) {
+            waitTime = updates.begin()->first - curTime;
         }
         threadCV.wait_for(l, std::chrono::milliseconds(waitTime));
     }
 }
+void PixelOverlayManager::updateModelEffect(PixelOverlayModel *m, uint64_t startTime) {
+    int32_t ms = m->updateRunningEffects();
+    if (ms != 0) {
+        std::unique_lock<std::mutex> l(threadLock);
+        if (!threadKeepRunning) {
+            return;
+        }
+        if (ms > 0) {
+            uint64_t t = startTime + ms;
+            updates[t].push_back(m);
+            l.unlock();
+            // may be sooner than what the update thread is waiting for
+            threadCV.notify_all();
+        } else {
+            afterOverlayModels.push_back(m);
+            hasAfterOverlayModels = true;
+        }
+    }
+}
+void PixelOverlayManager::stopOverlayModelEffects() {
+    if (updateThread != nullptr) {
+        std::unique_lock<std::mutex> l(threadLock);
+        threadKeepRunning = false;
+        l.unlock();
+        threadCV.notify_all();
+        updateThread->join();
+        delete updateThread;
+        updateThread = nullptr;
+
+        // make sure nothing is still rendering before the models go away
+        effectWorkers->wait();
+        l.lock();
+        updates.clear();
+        afterOverlayModels.clear();
+        hasAfterOverlayModels = false;
+    }
+}
 void PixelOverlayManager::removePeriodicUpdate(PixelOverlayModel*m) {
     std::unique_lock<std::mutex> l(threadLock);
     for (auto &a : updates) {
-        updates.begin()->second.remove(m);
+        a.second.remove(m);
     }
     afterOverlayModels.remove(m);
 }
@@ -908,6 +989,9 @@ void PixelOverlayManager::addPeriodicUpdate(int32_t initialDelayMS, PixelOverlay
     std::unique_lock<std::mutex> l(threadLock);
     if (updateThread == nullptr) {
         threadKeepRunning = true;
+        if (effectWorkers == nullptr) {
+            effectWorkers = new WorkerPool("OverlayEffects");
+        }
         updateThread = new std::thread(&PixelOverlayManager::doOverlayModelEffects, this);
     }
     if (initialDelayMS > 0) {
@@ -916,6 +1000,7 @@ void PixelOverlayManager::addPeriodicUpdate(int32_t initialDelayMS, PixelOverlay
         updates[nextTime].push_back(m);
     } else {
         afterOverlayModels.push_back(m);
+        hasAfterOverlayModels = true;
     }
     l.unlock();
     threadCV.notify_all();
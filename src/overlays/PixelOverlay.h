@@ -28,6 +28,9 @@
 class PixelOverlayState;
 class PixelOverlayModel;
 class OverlayRange;
+class OverlaySnapshot;
+class DirtyChannelRanges;
+class WorkerPool;
 
 class PixelOverlayManager : public httpserver::http_resource {
 public:
@@ -38,7 +41,14 @@ public:
     virtual const std::shared_ptr<httpserver::http_response> render_PUT(const httpserver::http_request &req) override;
 
     bool hasActiveOverlays();
-    void doOverlays(uint8_t *channels);
+    //if modified is not null, the channel ranges that were overlaid are added to it
+    void doOverlays(uint8_t *channels, DirtyChannelRanges *modified = nullptr);
+    //Pins the active overlays for the frame being processed so the caller
+    //knows up front whether doOverlays will modify the channels.  Returns
+    //nullptr if nothing is active, otherwise the snapshot must be passed
+    //to doOverlays which releases it.
+    const OverlaySnapshot *acquireActiveSnapshot();
+    void doOverlays(const OverlaySnapshot *snapshot, uint8_t *channels, DirtyChannelRanges *modified = nullptr);
     void modelStateChanged(PixelOverlayModel *, const PixelOverlayState &old, const PixelOverlayState &state);
     
     PixelOverlayModel* getModel(const std::string &name);
@@ -58,10 +68,16 @@ private:
     void loadModelMap();
     void RegisterCommands();
     
+    void publishActiveSnapshot();
+
     std::atomic_int numActive;
+    // activeModels/activeRanges are only touched by writers holding
+    // activeModelsLock, doOverlays reads the published snapshot instead
     std::list<PixelOverlayModel*> activeModels;
     std::list<OverlayRange> activeRanges;
     std::mutex activeModelsLock;
+    std::atomic<OverlaySnapshot*> activeSnapshot;
+    std::atomic_int snapshotReaders;
 
     
     
@@ -72,12 +88,18 @@ private:
     std::mutex   modelsLock;
     
     void doOverlayModelEffects();
+    void updateModelEffect(PixelOverlayModel *m, uint64_t startTime);
+    void stopOverlayModelEffects();
     std::thread *updateThread = nullptr;
+    // effects for different models are independent so they are rendered
+    // in parallel, each model has at most one update in flight
+    WorkerPool *effectWorkers = nullptr;
     bool threadKeepRunning = true;
     std::mutex   threadLock;
     std::condition_variable threadCV;
     std::map<uint64_t, std::list<PixelOverlayModel*>> updates;
     std::list<PixelOverlayModel*> afterOverlayModels;
+    std::atomic_bool hasAfterOverlayModels;
         
     void loadFonts();
     
@@ -0,0 +1,188 @@
+/*
+ *   Pixel Overlay blending kernels for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "PixelOverlayBlend.h"
+
+typedef uint8_t BlendVec __attribute__((vector_size(16)));
+typedef uint16_t BlendVec16 __attribute__((vector_size(16)));
+
+static const size_t BLEND_VEC_SIZE = sizeof(BlendVec);
+
+static inline BlendVec LoadVec(const uint8_t *p) {
+    BlendVec v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+static inline void StoreVec(uint8_t *p, const BlendVec &v) {
+    memcpy(p, &v, sizeof(v));
+}
+static inline BlendVec Select(const BlendVec &mask, const BlendVec &a, const BlendVec &b) {
+    return (a & mask) | (b & ~mask);
+}
+static inline BlendVec16 SplatVec16(uint16_t v) {
+    BlendVec16 r;
+    for (size_t x = 0; x < sizeof(r) / sizeof(uint16_t); x++) {
+        r[x] = v;
+    }
+    return r;
+}
+
+// scalar versions of the above for the tails, still branch free
+static inline uint8_t SelectByte(uint8_t mask, uint8_t a, uint8_t b) {
+    return (a & mask) | (b & ~mask);
+}
+static inline uint8_t NonZeroMask(uint8_t v) {
+    return -(uint8_t)(v != 0);
+}
+static inline uint8_t AlphaByte(uint8_t s, uint8_t d, uint16_t alpha) {
+    uint16_t t = s * alpha + d * (255 - alpha) + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+
+void BlendTransparent(uint8_t *dst, const uint8_t *src, size_t len) {
+    const BlendVec zero = {};
+    size_t x = 0;
+    for (; x + BLEND_VEC_SIZE <= len; x += BLEND_VEC_SIZE) {
+        BlendVec s = LoadVec(src + x);
+        BlendVec mask = (BlendVec)(s != zero);
+        StoreVec(dst + x, Select(mask, s, LoadVec(dst + x)));
+    }
+    for (; x < len; x++) {
+        dst[x] = SelectByte(NonZeroMask(src[x]), src[x], dst[x]);
+    }
+}
+
+// For a vector starting at a given position within an RGB triplet, the
+// masks of the bytes that need to OR in the byte one and two positions
+// after/before them to cover all three channels of their own pixel.
+struct RGBPhaseMasks {
+    BlendVec next1, next2, prev1, prev2;
+};
+static RGBPhaseMasks CreatePhaseMasks(int phase) {
+    RGBPhaseMasks m;
+    for (size_t x = 0; x < BLEND_VEC_SIZE; x++) {
+        int p = (phase + x) % 3;
+        m.next1[x] = (p == 0 || p == 1) ? 0xFF : 0;
+        m.next2[x] = (p == 0) ? 0xFF : 0;
+        m.prev1[x] = (p == 1 || p == 2) ? 0xFF : 0;
+        m.prev2[x] = (p == 2) ? 0xFF : 0;
+    }
+    return m;
+}
+static const RGBPhaseMasks RGB_PHASE_MASKS[3] = {
+    CreatePhaseMasks(0), CreatePhaseMasks(1), CreatePhaseMasks(2)
+};
+
+static inline void BlendTransparentRGBVec(uint8_t *dst, const uint8_t *src, const RGBPhaseMasks &m) {
+    const BlendVec zero = {};
+    BlendVec s = LoadVec(src);
+    BlendVec pix = s
+        | (LoadVec(src + 1) & m.next1) | (LoadVec(src + 2) & m.next2)
+        | (LoadVec(src - 1) & m.prev1) | (LoadVec(src - 2) & m.prev2);
+    BlendVec mask = (BlendVec)(pix != zero);
+    StoreVec(dst, Select(mask, s, LoadVec(dst)));
+}
+
+static inline void BlendTransparentRGBPixel(uint8_t *dst, const uint8_t *src) {
+    uint8_t mask = NonZeroMask(src[0] | src[1] | src[2]);
+    dst[0] = SelectByte(mask, src[0], dst[0]);
+    dst[1] = SelectByte(mask, src[1], dst[1]);
+    dst[2] = SelectByte(mask, src[2], dst[2]);
+}
+
+void BlendTransparentRGB(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t x = 0;
+    // The vector loop reads two bytes before and after each 16 byte block
+    // so the first pixel and the tail are done one pixel at a time.  Each
+    // 48 byte step covers 16 complete pixels.
+    if (len >= 3) {
+        BlendTransparentRGBPixel(dst, src);
+        x = 3;
+    }
+    for (; x + 3 * BLEND_VEC_SIZE + 2 <= len; x += 3 * BLEND_VEC_SIZE) {
+        BlendTransparentRGBVec(dst + x, src + x, RGB_PHASE_MASKS[0]);
+        BlendTransparentRGBVec(dst + x + BLEND_VEC_SIZE, src + x + BLEND_VEC_SIZE, RGB_PHASE_MASKS[BLEND_VEC_SIZE % 3]);
+        BlendTransparentRGBVec(dst + x + 2 * BLEND_VEC_SIZE, src + x + 2 * BLEND_VEC_SIZE, RGB_PHASE_MASKS[(2 * BLEND_VEC_SIZE) % 3]);
+    }
+    for (; x + 3 <= len; x += 3) {
+        BlendTransparentRGBPixel(dst + x, src + x);
+    }
+    for (; x < len; x++) {
+        dst[x] = SelectByte(NonZeroMask(src[x]), src[x], dst[x]);
+    }
+}
+
+void BlendAdditive(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t x = 0;
+    for (; x + BLEND_VEC_SIZE <= len; x += BLEND_VEC_SIZE) {
+        BlendVec d = LoadVec(dst + x);
+        BlendVec sum = d + LoadVec(src + x);
+        // wrapped around if the sum is smaller than either input
+        StoreVec(dst + x, sum | (BlendVec)(sum < d));
+    }
+    for (; x < len; x++) {
+        uint8_t sum = dst[x] + src[x];
+        dst[x] = sum | -(uint8_t)(sum < dst[x]);
+    }
+}
+
+void BlendMaximum(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t x = 0;
+    for (; x + BLEND_VEC_SIZE <= len; x += BLEND_VEC_SIZE) {
+        BlendVec s = LoadVec(src + x);
+        BlendVec d = LoadVec(dst + x);
+        StoreVec(dst + x, Select((BlendVec)(s > d), s, d));
+    }
+    for (; x < len; x++) {
+        dst[x] = SelectByte(-(uint8_t)(src[x] > dst[x]), src[x], dst[x]);
+    }
+}
+
+void BlendAlpha(uint8_t *dst, const uint8_t *src, size_t len, uint8_t alpha) {
+    if (alpha == 255) {
+        memcpy(dst, src, len);
+        return;
+    }
+    if (alpha == 0) {
+        return;
+    }
+    // The even and odd bytes are blended separately in 16 bit lanes,
+    // 255 * 255 + 128 still fits so there is no need to widen further.
+    // Divide by 255 with rounding is (t + (t >> 8)) >> 8 with t = x + 128
+    const BlendVec16 lowMask = SplatVec16(0x00FF);
+    const BlendVec16 a = SplatVec16(alpha);
+    const BlendVec16 ia = SplatVec16(255 - alpha);
+    const BlendVec16 half = SplatVec16(128);
+    size_t x = 0;
+    for (; x + BLEND_VEC_SIZE <= len; x += BLEND_VEC_SIZE) {
+        BlendVec16 s = (BlendVec16)LoadVec(src + x);
+        BlendVec16 d = (BlendVec16)LoadVec(dst + x);
+
+        BlendVec16 even = (s & lowMask) * a + (d & lowMask) * ia + half;
+        BlendVec16 odd = (s >> 8) * a + (d >> 8) * ia + half;
+        even = (even + (even >> 8)) >> 8;
+        odd = (odd + (odd >> 8)) >> 8;
+
+        StoreVec(dst + x, (BlendVec)(even | (odd << 8)));
+    }
+    for (; x < len; x++) {
+        dst[x] = AlphaByte(src[x], dst[x], alpha);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+/*
+ *   Pixel Overlay blending kernels for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+// Each kernel blends len bytes of overlay data (src) onto the channel
+// data (dst).  They are branch free and process 16 bytes at a time using
+// the compiler's generic vector types so the same code is emitted as
+// SSE2 on x86 and NEON on ARM.
+
+// dst = src where src is non-zero
+void BlendTransparent(uint8_t *dst, const uint8_t *src, size_t len);
+
+// dst = src for every RGB triplet where any of the three src channels are
+// non-zero.  Any trailing partial triplet is handled like BlendTransparent
+void BlendTransparentRGB(uint8_t *dst, const uint8_t *src, size_t len);
+
+// dst = min(dst + src, 255)
+void BlendAdditive(uint8_t *dst, const uint8_t *src, size_t len);
+
+// dst = max(dst, src)
+void BlendMaximum(uint8_t *dst, const uint8_t *src, size_t len);
+
+// dst = (src * alpha + dst * (255 - alpha)) / 255
+void BlendAlpha(uint8_t *dst, const uint8_t *src, size_t len, uint8_t alpha);
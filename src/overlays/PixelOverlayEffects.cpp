@@ -20,6 +20,7 @@
 #include <magick/type.h>
 
 #include "PixelOverlayEffects.h"
+#include "PixelOverlayFont.h"
 #include "PixelOverlayModel.h"
 #include "PixelOverlay.h"
 
@@ -472,6 +473,108 @@ public:
         return "Center";
     }
 
+    // Renders the text with GraphicsMagick into a new malloc'd RGB buffer.
+    // Only used for fonts FreeType can't load directly.
+    uint8_t *renderTextMagick(const std::string &msg,
+                              int r, int g, int b,
+                              const std::string &font,
+                              int fontSize,
+                              bool antialias,
+                              int &w, int &h, int &ascent) {
+        Magick::Image image(Magick::Geometry(1, 1), Magick::Color("black"));
+        image.quiet(true);
+        image.depth(8);
+        image.font(font);
+        image.fontPointsize(fontSize);
+        image.antiAlias(antialias);
+
+        int maxWid = 0;
+        int totalHi = 0;
+        Magick::TypeMetric metrics;
+        for (auto &line : PixelOverlayFont::splitLines(msg)) {
+            image.fontTypeMetrics(line, &metrics);
+            maxWid = std::max(maxWid, (int)metrics.textWidth());
+            totalHi += (int)metrics.textHeight();
+        }
+        ascent = metrics.ascent();
+        if (w == 0 || h == 0) {
+            w = std::max(maxWid, 1);
+            h = std::max(totalHi, 1);
+        }
+
+        double rr = r;
+        double rg = g;
+        double rb = b;
+        rr /= 255.0f;
+        rg /= 255.0f;
+        rb /= 255.0f;
+
+        Magick::Image image2(Magick::Geometry(w, h), Magick::Color("black"));
+        image2.quiet(true);
+        image2.depth(8);
+        image2.font(font);
+        image2.fontPointsize(fontSize);
+        image2.fillColor(Magick::Color(Magick::Color::scaleDoubleToQuantum(rr),
+                                       Magick::Color::scaleDoubleToQuantum(rg),
+                                       Magick::Color::scaleDoubleToQuantum(rb)));
+        image2.antiAlias(antialias);
+        image2.strokeAntiAlias(antialias);
+        image2.annotate(msg, Magick::CenterGravity);
+        image2.modifyImage();
+
+        const MagickLib::PixelPacket *pixel_cache = image2.getConstPixels(0,0, image2.columns(), image2.rows());
+        uint8_t *newData = (uint8_t*)malloc(image2.columns() * image2.rows() * 3);
+        for (int yi = 0; yi < image2.rows(); yi++) {
+            int idx = yi * image2.columns();
+            int nidx = yi * image2.columns() * 3;
+
+            for (int xi = 0; xi < image2.columns(); xi++) {
+                const MagickLib::PixelPacket *ptr2 = &pixel_cache[idx + xi];
+                uint8_t *np = &newData[nidx + (xi*3)];
+
+                float r = Magick::Color::scaleQuantumToDouble(ptr2->red);
+                float g = Magick::Color::scaleQuantumToDouble(ptr2->green);
+                float b = Magick::Color::scaleQuantumToDouble(ptr2->blue);
+                r *= 255;
+                g *= 255;
+                b *= 255;
+                np[0] = r;
+                np[1] = g;
+                np[2] = b;
+            }
+        }
+        return newData;
+    }
+
+    // Renders the text into a new malloc'd RGB buffer.  If w and h are 0
+    // the buffer is sized to fit the text, otherwise the text is centered
+    // in a w x h buffer.
+    uint8_t *renderText(const std::string &msg,
+                        int r, int g, int b,
+                        const std::string &font,
+                        int fontSize,
+                        bool antialias,
+                        int &w, int &h, int &ascent) {
+        std::shared_ptr<PixelOverlayFont> f;
+        if (font.find('/') != std::string::npos) {
+            // mapFont found the TrueType file so FreeType can use it directly
+            f = PixelOverlayFont::getFont(font, fontSize, antialias);
+        }
+        if (!f) {
+            return renderTextMagick(msg, r, g, b, font, fontSize, antialias, w, h, ascent);
+        }
+        int tw, th;
+        f->measureText(msg, tw, th);
+        ascent = f->getAscent();
+        if (w == 0 || h == 0) {
+            w = std::max(tw, 1);
+            h = std::max(th, 1);
+        }
+        uint8_t *newData = (uint8_t*)calloc(w * h * 3, 1);
+        f->drawText(newData, w, h, msg, (w - tw) / 2, (h - th) / 2, r, g, b);
+        return newData;
+    }
+
     void doText(PixelOverlayModel *m,
                 const std::string &msg,
                 int r, int g, int b,
@@ -483,13 +586,6 @@ public:
                 const std::string &autoEnable,
                 int duration) {
 
-        Magick::Image image(Magick::Geometry(m->getWidth(),m->getHeight()), Magick::Color("black"));
-        image.quiet(true);
-        image.depth(8);
-        image.font(font);
-        image.fontPointsize(fontSize);
-        image.antiAlias(antialias);
-
         bool disableWhenDone = false;
         
         PixelOverlayState st(autoEnable);
@@ -499,52 +595,14 @@ public:
             disableWhenDone = true;
         }
         
-        int maxWid = 0;
-        int totalHi = 0;
-        
-        int lines = 1;
-        int last = 0;
-        for (int x = 0; x < msg.length(); x++) {
-            if (msg[x] == '\n' || ((x < msg.length() - 1) && msg[x] == '\\' && msg[x+1] == 'n')) {
-                lines++;
-                std::string newM = msg.substr(last, x);
-                Magick::TypeMetric metrics;
-                image.fontTypeMetrics(newM, &metrics);
-                maxWid = std::max(maxWid,  (int)metrics.textWidth());
-                totalHi += (int)metrics.textHeight();
-                if (msg[x] == '\n') {
-                    last = x + 1;
-                } else {
-                    last = x + 2;
-                }
-            }
-        }
-        std::string newM = msg.substr(last);
-        Magick::TypeMetric metrics;
-        image.fontTypeMetrics(newM, &metrics);
-        maxWid = std::max(maxWid,  (int)metrics.textWidth());
-        totalHi += (int)metrics.textHeight();
-        
         if (position == "Centered" || position == "Center") {
-            image.magick("RGB");
             //one shot, just draw the text and return
-            double rr = r;
-            double rg = g;
-            double rb = b;
-            rr /= 255.0f;
-            rg /= 255.0f;
-            rb /= 255.0f;
-            
-            image.fillColor(Magick::Color(Magick::Color::scaleDoubleToQuantum(rr),
-                                          Magick::Color::scaleDoubleToQuantum(rg),
-                                          Magick::Color::scaleDoubleToQuantum(rb)));
-            image.antiAlias(antialias);
-            image.strokeAntiAlias(antialias);
-            image.annotate(msg, Magick::CenterGravity);
-            Magick::Blob blob;
-            image.write( &blob );
-            
-            m->setData((uint8_t*)blob.data());
+            int w = m->getWidth();
+            int h = m->getHeight();
+            int ascent = 0;
+            uint8_t *data = renderText(msg, r, g, b, font, fontSize, antialias, w, h, ascent);
+            m->setData(data);
+            free(data);
 
             if (disableWhenDone) {
                 int nd = 25;
@@ -555,40 +613,22 @@ public:
             }
         } else {
             //movement
-            double rr = r;
-            double rg = g;
-            double rb = b;
-            rr /= 255.0f;
-            rg /= 255.0f;
-            rb /= 255.0f;
-                    
-            Magick::Image image2(Magick::Geometry(maxWid, totalHi), Magick::Color("black"));
-            image2.quiet(true);
-            image2.depth(8);
-            image2.font(font);
-            image2.fontPointsize(fontSize);
-            image2.antiAlias(antialias);
-
-            image2.fillColor(Magick::Color(Magick::Color::scaleDoubleToQuantum(rr),
-                                          Magick::Color::scaleDoubleToQuantum(rg),
-                                          Magick::Color::scaleDoubleToQuantum(rb)));
-            image2.antiAlias(antialias);
-            image2.strokeAntiAlias(antialias);
-            image2.annotate(msg, Magick::CenterGravity);
-
-            double y = (m->getHeight() / 2.0) - ((totalHi) / 2.0);
-            double x = (m->getWidth() / 2.0) - (maxWid / 2.0);
+            int w = 0;
+            int h = 0;
+            int ascent = 0;
+            uint8_t *newData = renderText(msg, r, g, b, font, fontSize, antialias, w, h, ascent);
+
+            double y = (m->getHeight() / 2.0) - (h / 2.0);
+            double x = (m->getWidth() / 2.0) - (w / 2.0);
             if (position == "R2L") {
                 x = m->getWidth();
             } else if (position == "L2R") {
-                x = -maxWid;
+                x = -w;
             } else if (position == "B2T") {
                 y = m->getHeight();
             } else if (position == "T2B") {
-                y =  -metrics.ascent();
+                y = -ascent;
             }
-            image2.modifyImage();
-            
             
             TextMovementEffect *ef = dynamic_cast<TextMovementEffect*>(m->getRunningEffect());
             if (ef == nullptr) {
@@ -597,27 +637,6 @@ public:
                 ef->y = (int)y;
             }
 
-            const MagickLib::PixelPacket *pixel_cache = image2.getConstPixels(0,0, image2.columns(), image2.rows());
-            uint8_t *newData = (uint8_t*)malloc(image2.columns() * image2.rows() * 3);
-            for (int yi = 0; yi < image2.rows(); yi++) {
-                int idx = yi * image2.columns();
-                int nidx = yi * image2.columns() * 3;
-
-                for (int xi = 0; xi < image2.columns(); xi++) {
-                    const MagickLib::PixelPacket *ptr2 = &pixel_cache[idx + xi];
-                    uint8_t *np = &newData[nidx + (xi*3)];
-                    
-                    float r = Magick::Color::scaleQuantumToDouble(ptr2->red);
-                    float g = Magick::Color::scaleQuantumToDouble(ptr2->green);
-                    float b = Magick::Color::scaleQuantumToDouble(ptr2->blue);
-                    r *= 255;
-                    g *= 255;
-                    b *= 255;
-                    np[0] = r;
-                    np[1] = g;
-                    np[2] = b;
-                }
-            }
             ef->speed = pixelsPerSecond;
             ef->disableWhenDone = disableWhenDone;
             ef->direction = position;
@@ -627,8 +646,8 @@ public:
             }
             uint8_t *old= ef->imageData;
             ef->imageData = newData;
-            ef->imageDataCols = image2.columns();
-            ef->imageDataRows = image2.rows();
+            ef->imageDataCols = w;
+            ef->imageDataRows = h;
             ef->copyImageData(ef->x, ef->y);
             m->setRunningEffect(ef, t);
             free(old);
@@ -0,0 +1,262 @@
+/*
+ *   Pixel Overlay text rendering for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "fpp-pch.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "PixelOverlayFont.h"
+
+#define FONT_ATLAS_WIDTH 512
+
+static std::mutex fontCacheLock;
+static FT_Library ftLibrary = nullptr;
+static std::map<std::string, std::shared_ptr<PixelOverlayFont>> fontCache;
+
+std::shared_ptr<PixelOverlayFont> PixelOverlayFont::getFont(const std::string &file, int size, bool antialias) {
+    std::string key = file + ":" + std::to_string(size) + (antialias ? ":aa" : "");
+    std::unique_lock<std::mutex> lock(fontCacheLock);
+    auto it = fontCache.find(key);
+    if (it != fontCache.end()) {
+        return it->second;
+    }
+    if (ftLibrary == nullptr && FT_Init_FreeType(&ftLibrary)) {
+        LogErr(VB_CHANNELOUT, "Could not initialize FreeType\n");
+        ftLibrary = nullptr;
+        return nullptr;
+    }
+    FT_Face face;
+    if (FT_New_Face(ftLibrary, file.c_str(), 0, &face)) {
+        LogDebug(VB_CHANNELOUT, "FreeType could not load font %s\n", file.c_str());
+        // remember the failure so we don't retry every render
+        fontCache[key] = nullptr;
+        return nullptr;
+    }
+    if (FT_Set_Pixel_Sizes(face, 0, size)) {
+        LogDebug(VB_CHANNELOUT, "Font %s does not support size %d\n", file.c_str(), size);
+        FT_Done_Face(face);
+        fontCache[key] = nullptr;
+        return nullptr;
+    }
+    std::shared_ptr<PixelOverlayFont> font(new PixelOverlayFont(face, antialias));
+    fontCache[key] = font;
+    return font;
+}
+
+PixelOverlayFont::PixelOverlayFont(FT_Face f, bool aa)
+    : face(f), antialias(aa), atlasHeight(0), shelfX(0), shelfY(0), shelfHeight(0) {
+    hasKerning = FT_HAS_KERNING(face);
+    ascent = (face->size->metrics.ascender + 63) >> 6;
+    lineHeight = (face->size->metrics.height + 63) >> 6;
+    if (lineHeight <= 0) {
+        lineHeight = 1;
+    }
+    // most text is ASCII, get those rasterized up front
+    for (uint32_t c = 32; c < 127; c++) {
+        getGlyph(c);
+    }
+}
+
+PixelOverlayFont::~PixelOverlayFont() {
+    std::unique_lock<std::mutex> lock(fontCacheLock);
+    FT_Done_Face(face);
+}
+
+std::vector<std::string> PixelOverlayFont::splitLines(const std::string &text) {
+    std::vector<std::string> lines;
+    size_t last = 0;
+    for (size_t x = 0; x < text.length(); x++) {
+        if (text[x] == '\n') {
+            lines.push_back(text.substr(last, x - last));
+            last = x + 1;
+        } else if (text[x] == '\\' && (x + 1) < text.length() && text[x + 1] == 'n') {
+            lines.push_back(text.substr(last, x - last));
+            last = x + 2;
+            x++;
+        }
+    }
+    lines.push_back(text.substr(last));
+    return lines;
+}
+
+static std::vector<uint32_t> DecodeUTF8(const std::string &s) {
+    std::vector<uint32_t> codepoints;
+    codepoints.reserve(s.length());
+    for (size_t x = 0; x < s.length(); ) {
+        uint8_t c = s[x];
+        int extra = 0;
+        uint32_t cp = c;
+        if (c >= 0xF0) {
+            extra = 3;
+            cp = c & 0x07;
+        } else if (c >= 0xE0) {
+            extra = 2;
+            cp = c & 0x0F;
+        } else if (c >= 0xC0) {
+            extra = 1;
+            cp = c & 0x1F;
+        }
+        x++;
+        for (int e = 0; e < extra && x < s.length() && (s[x] & 0xC0) == 0x80; e++, x++) {
+            cp = (cp << 6) | (s[x] & 0x3F);
+        }
+        codepoints.push_back(cp);
+    }
+    return codepoints;
+}
+
+void PixelOverlayFont::addToAtlas(Glyph &glyph, const uint8_t *bitmap, int pitch, bool mono) {
+    if (glyph.width > FONT_ATLAS_WIDTH) {
+        glyph.width = FONT_ATLAS_WIDTH;
+    }
+    if ((shelfX + glyph.width) > FONT_ATLAS_WIDTH) {
+        // start a new shelf
+        shelfY += shelfHeight;
+        shelfX = 0;
+        shelfHeight = 0;
+    }
+    shelfHeight = std::max(shelfHeight, glyph.height);
+    if ((shelfY + shelfHeight) > atlasHeight) {
+        atlasHeight = shelfY + shelfHeight;
+        atlas.resize(atlasHeight * FONT_ATLAS_WIDTH);
+    }
+    glyph.atlasX = shelfX;
+    glyph.atlasY = shelfY;
+    shelfX += glyph.width;
+
+    for (int y = 0; y < glyph.height; y++) {
+        const uint8_t *src = bitmap + y * pitch;
+        uint8_t *dst = &atlas[(glyph.atlasY + y) * FONT_ATLAS_WIDTH + glyph.atlasX];
+        for (int x = 0; x < glyph.width; x++) {
+            if (mono) {
+                dst[x] = (src[x >> 3] & (0x80 >> (x & 7))) ? 0xFF : 0;
+            } else {
+                dst[x] = src[x];
+            }
+        }
+    }
+}
+
+const PixelOverlayFont::Glyph &PixelOverlayFont::getGlyph(uint32_t codepoint) {
+    auto it = glyphs.find(codepoint);
+    if (it != glyphs.end()) {
+        return it->second;
+    }
+    Glyph &glyph = glyphs[codepoint];
+    glyph.index = FT_Get_Char_Index(face, codepoint);
+    int flags = FT_LOAD_RENDER | (antialias ? FT_LOAD_TARGET_NORMAL : (FT_LOAD_TARGET_MONO | FT_LOAD_MONOCHROME));
+    if (FT_Load_Glyph(face, glyph.index, flags)) {
+        return glyph;
+    }
+    FT_GlyphSlot slot = face->glyph;
+    glyph.advance = (slot->advance.x + 32) >> 6;
+    glyph.left = slot->bitmap_left;
+    glyph.top = slot->bitmap_top;
+    glyph.width = slot->bitmap.width;
+    glyph.height = slot->bitmap.rows;
+    if (glyph.width && glyph.height && slot->bitmap.pitch > 0) {
+        addToAtlas(glyph, slot->bitmap.buffer, slot->bitmap.pitch,
+                   slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO);
+    } else {
+        glyph.width = glyph.height = 0;
+    }
+    return glyph;
+}
+
+int PixelOverlayFont::lineWidth(const std::vector<uint32_t> &codepoints) {
+    int width = 0;
+    uint32_t prev = 0;
+    for (auto cp : codepoints) {
+        const Glyph &g = getGlyph(cp);
+        if (hasKerning && prev && g.index) {
+            FT_Vector delta;
+            FT_Get_Kerning(face, prev, g.index, FT_KERNING_DEFAULT, &delta);
+            width += delta.x >> 6;
+        }
+        width += g.advance;
+        prev = g.index;
+    }
+    return width;
+}
+
+void PixelOverlayFont::measureText(const std::string &text, int &width, int &height) {
+    std::unique_lock<std::mutex> lock(fontLock);
+    std::vector<std::string> lines = splitLines(text);
+    width = 0;
+    for (auto &l : lines) {
+        width = std::max(width, lineWidth(DecodeUTF8(l)));
+    }
+    height = lines.size() * lineHeight;
+}
+
+void PixelOverlayFont::drawText(uint8_t *buffer, int w, int h, const std::string &text,
+                                int x, int y, int r, int g, int b) {
+    std::unique_lock<std::mutex> lock(fontLock);
+    std::vector<std::vector<uint32_t>> lines;
+    std::vector<int> widths;
+    int boxWidth = 0;
+    for (auto &l : splitLines(text)) {
+        lines.push_back(DecodeUTF8(l));
+        widths.push_back(lineWidth(lines.back()));
+        boxWidth = std::max(boxWidth, widths.back());
+    }
+    const uint8_t color[3] = { (uint8_t)r, (uint8_t)g, (uint8_t)b };
+
+    for (int l = 0; l < lines.size(); l++) {
+        int penX = x + (boxWidth - widths[l]) / 2;
+        int baseline = y + l * lineHeight + ascent;
+        uint32_t prev = 0;
+        for (auto cp : lines[l]) {
+            const Glyph &glyph = getGlyph(cp);
+            if (hasKerning && prev && glyph.index) {
+                FT_Vector delta;
+                FT_Get_Kerning(face, prev, glyph.index, FT_KERNING_DEFAULT, &delta);
+                penX += delta.x >> 6;
+            }
+            prev = glyph.index;
+
+            int gx = penX + glyph.left;
+            int gy = baseline - glyph.top;
+            penX += glyph.advance;
+
+            int x0 = std::max(0, -gx);
+            int x1 = std::min(glyph.width, w - gx);
+            int y0 = std::max(0, -gy);
+            int y1 = std::min(glyph.height, h - gy);
+            for (int yi = y0; yi < y1; yi++) {
+                const uint8_t *cov = &atlas[(glyph.atlasY + yi) * FONT_ATLAS_WIDTH + glyph.atlasX];
+                uint8_t *dst = &buffer[((gy + yi) * w + gx) * 3];
+                for (int xi = x0; xi < x1; xi++) {
+                    uint8_t a = cov[xi];
+                    if (a == 0) {
+                        continue;
+                    }
+                    uint8_t *p = &dst[xi * 3];
+                    if (a == 0xFF) {
+                        p[0] = color[0];
+                        p[1] = color[1];
+                        p[2] = color[2];
+                    } else {
+                        for (int c = 0; c < 3; c++) {
+                            p[c] = (color[c] * a + p[c] * (255 - a) + 127) / 255;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
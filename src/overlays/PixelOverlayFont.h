@@ -0,0 +1,85 @@
+#pragma once
+/*
+ *   Pixel Overlay text rendering for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef struct FT_FaceRec_ *FT_Face;
+
+// A TrueType font at a fixed pixel size.  The font is loaded once with
+// FreeType and each glyph is rasterized into a coverage atlas the first
+// time it's used.  After that, drawing text is just blitting from the
+// atlas into an RGB buffer such as a model's overlay buffer.
+class PixelOverlayFont {
+public:
+    // Returns the cached font for the TrueType file at the given pixel
+    // size, or nullptr if FreeType cannot load the file
+    static std::shared_ptr<PixelOverlayFont> getFont(const std::string &file, int size, bool antialias);
+
+    ~PixelOverlayFont();
+
+    int getAscent() const { return ascent; }
+    int getLineHeight() const { return lineHeight; }
+
+    // lines are separated by a newline or a literal "\n"
+    static std::vector<std::string> splitLines(const std::string &text);
+
+    // size of the box needed to draw the text
+    void measureText(const std::string &text, int &width, int &height);
+
+    // Draws the text into a w x h RGB buffer with the top left corner of
+    // the text box at x, y, clipping to the buffer.  Each line is centered
+    // within the box and blended onto the buffer by the glyph coverage
+    void drawText(uint8_t *buffer, int w, int h, const std::string &text,
+                  int x, int y, int r, int g, int b);
+
+private:
+    PixelOverlayFont(FT_Face face, bool antialias);
+
+    class Glyph {
+    public:
+        uint32_t index = 0;
+        int atlasX = 0;
+        int atlasY = 0;
+        int width = 0;
+        int height = 0;
+        int left = 0;
+        int top = 0;
+        int advance = 0;
+    };
+    const Glyph &getGlyph(uint32_t codepoint);
+    void addToAtlas(Glyph &glyph, const uint8_t *bitmap, int pitch, bool mono);
+    int lineWidth(const std::vector<uint32_t> &codepoints);
+
+    std::mutex fontLock;
+    FT_Face face;
+    bool antialias;
+    bool hasKerning;
+    int ascent;
+    int lineHeight;
+
+    std::map<uint32_t, Glyph> glyphs;
+    std::vector<uint8_t> atlas;
+    int atlasHeight;
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+};
@@ -25,6 +25,7 @@
 #include "Plugins.h"
 #include "PixelOverlayModel.h"
 #include "PixelOverlay.h"
+#include "PixelOverlayBlend.h"
 #include "PixelOverlayEffects.h"
 
 
@@ -39,13 +40,17 @@ static uint8_t* createChannelDataMemory(const std::string &dataName, uint32_t si
 }
 
 PixelOverlayModel::PixelOverlayModel(const Json::Value &c)
-    : config(c), overlayBufferData(nullptr), channelData(nullptr), runningEffect(nullptr)
+    : config(c), overlayBufferData(nullptr), channelData(nullptr), runningEffect(nullptr), opacity(255),
+      effectUpdateCount(0), effectUpdateLastUS(0), effectUpdateMaxUS(0), effectUpdateTotalUS(0)
 {
     name = config["Name"].asString();
     replaceAll(name, "/", "_");
     startChannel = config["StartChannel"].asInt();
     startChannel--; //need to be 0 based
     channelCount = config["ChannelCount"].asInt();
+    if (config.isMember("Opacity")) {
+        opacity = std::clamp(config["Opacity"].asInt(), 0, 255);
+    }
     int strings = config["StringCount"].asInt();
     int sps = config["StrandsPerString"].asInt();
     
@@ -182,6 +187,7 @@ PixelOverlayModel::PixelOverlayModel(const Json::Value &c)
             }
         }
     }
+    buildChannelMapSpans();
 }
 PixelOverlayModel::~PixelOverlayModel() {
     if (channelData) {
@@ -214,44 +220,79 @@ void PixelOverlayModel::doOverlay(uint8_t *channels) {
     }
     
     int st = state.getState();
-    if (((st == 2) || (st == 3)) &&
+    uint8_t *src = channelData;
+    uint8_t *dst = &channels[startChannel];
+    if (((st == 2) || (st == 3) || (st == 4) || (st == 5) || (st == 6)) &&
         (!IsEffectRunning()) &&
         (!sequence->IsSequenceRunning()) &&
         !PluginManager::INSTANCE.hasPlugins()) {
-        //there is nothing running that we would be overlaying so do a straight copy
-        st = 1;
+        //there is nothing running that we would be overlaying so do a straight copy,
+        //alpha is blended onto black so it doesn't blend onto last frame's result
+        if (st == 6) {
+            memset(dst, 0, channelCount);
+        } else {
+            st = 1;
+        }
     }
     
-    uint8_t *src = channelData;
-    uint8_t *dst = &channels[startChannel];
     switch (st) {
         case 1: //Active - Opaque
             memcpy(dst, src, channelCount);
             break;
         case 2: //Active Transparent
-            for (int j = 0; j < channelCount; j++, src++, dst++) {
-                if (*src) {
-                    *dst = *src;
-                }
-            }
+            BlendTransparent(dst, src, channelCount);
             break;
-        case 3: //Active Transparent RGB {
-            for (int j = 0; j < channelCount; j += 3, src += 3, dst += 3) {
-                if (src[0] || src[1] || src[2]) {
-                    dst[0] = src[0];
-                    dst[1] = src[1];
-                    dst[2] = src[2];
-                }
-            }
+        case 3: //Active Transparent RGB
+            BlendTransparentRGB(dst, src, channelCount);
+            break;
+        case 4: //Active Additive
+            BlendAdditive(dst, src, channelCount);
+            break;
+        case 5: //Active Maximum
+            BlendMaximum(dst, src, channelCount);
+            break;
+        case 6: //Active Alpha
+            BlendAlpha(dst, src, channelCount, opacity);
             break;
     }
 }
 
-void PixelOverlayModel::setData(const uint8_t *data) {
-    for (int c = 0; c < (width*height*3); c++) {
-        if (channelMap[c] != FPPD_OFF_CHANNEL) {
-            channelData[channelMap[c]] = data[c];
+// shorter runs are cheaper to gather than to memcpy
+#define MIN_CHANNEL_MAP_SPAN 16
+
+void PixelOverlayModel::buildChannelMapSpans() {
+    channelMapSpans.clear();
+    channelMapGather.clear();
+    uint32_t count = width * height * 3;
+    uint32_t c = 0;
+    while (c < count) {
+        if (channelMap[c] == FPPD_OFF_CHANNEL) {
+            c++;
+            continue;
         }
+        uint32_t len = 1;
+        while ((c + len) < count && channelMap[c + len] == (channelMap[c] + len)) {
+            len++;
+        }
+        if (len >= MIN_CHANNEL_MAP_SPAN) {
+            channelMapSpans.push_back({c, channelMap[c], len});
+        } else {
+            for (uint32_t x = c; x < (c + len); x++) {
+                channelMapGather.push_back(std::make_pair(x, channelMap[x]));
+            }
+        }
+        c += len;
+    }
+    LogDebug(VB_CHANNELOUT, "Overlay model %s channel map: %d spans, %d gathered channels\n",
+             name.c_str(), (int)channelMapSpans.size(), (int)channelMapGather.size());
+}
+
+void PixelOverlayModel::setData(const uint8_t *data) {
+    for (auto &span : channelMapSpans) {
+        memcpy(&channelData[span.dst], &data[span.src], span.len);
+    }
+    for (auto &g : channelMapGather) {
+        channelData[g.second] = data[g.first];
     }
 }
 
@@ -445,7 +486,15 @@ void PixelOverlayModel::toJson(Json::Value &result) {
 int32_t PixelOverlayModel::updateRunningEffects() {
     std::unique_lock<std::mutex> l(effectLock);
     if (runningEffect) {
+        uint64_t startTime = GetTime();
         int32_t v = runningEffect->update();
+        uint32_t us = GetTime() - startTime;
+        effectUpdateLastUS = us;
+        effectUpdateTotalUS += us;
+        effectUpdateCount++;
+        if (us > effectUpdateMaxUS) {
+            effectUpdateMaxUS = us;
+        }
         if (v == 0) {
             delete runningEffect;
             runningEffect = nullptr;
@@ -463,10 +512,24 @@ void PixelOverlayModel::setRunningEffect(RunningEffect *ef, int32_t firstUpdateM
         }
         PixelOverlayManager::INSTANCE.removePeriodicUpdate(this);
     }
+    if (runningEffect != ef) {
+        effectUpdateCount = 0;
+        effectUpdateLastUS = 0;
+        effectUpdateMaxUS = 0;
+        effectUpdateTotalUS = 0;
+    }
     runningEffect = ef;
     PixelOverlayManager::INSTANCE.addPeriodicUpdate(firstUpdateMS, this);
 }
 
+void PixelOverlayModel::getEffectStatsJson(Json::Value &v) {
+    uint32_t count = effectUpdateCount;
+    v["updates"] = count;
+    v["lastUS"] = (uint32_t)effectUpdateLastUS;
+    v["maxUS"] = (uint32_t)effectUpdateMaxUS;
+    v["avgUS"] = count ? (uint32_t)(effectUpdateTotalUS / count) : 0;
+}
+
 bool PixelOverlayModel::applyEffect(const std::string &autoState, const std::string &effect, const std::vector<std::string> &args) {
     PixelOverlayEffect *pe = PixelOverlayEffect::GetPixelOverlayEffect(effect);
     if (pe) {
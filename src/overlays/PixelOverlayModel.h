@@ -16,6 +16,7 @@
  *   along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
 #include <thread>
 #include <mutex>
 #include <jsoncpp/json/json.h>
@@ -28,7 +29,10 @@ public:
         Disabled,
         Enabled,
         Transparent,
-        TransparentRGB
+        TransparentRGB,
+        Additive,
+        Maximum,
+        Alpha
     };
 
     PixelOverlayState() : state(PixelState::Disabled) {}
@@ -43,6 +47,12 @@ public:
             state = PixelState::Transparent;
         } else if (v == "TransparentRGB" || v == "Transparent RGB") {
             state = PixelState::TransparentRGB;
+        } else if (v == "Additive") {
+            state = PixelState::Additive;
+        } else if (v == "Maximum" || v == "Max") {
+            state = PixelState::Maximum;
+        } else if (v == "Alpha") {
+            state = PixelState::Alpha;
         } else {
             state = PixelState::Disabled;
         }
@@ -69,6 +79,10 @@ public:
     
     PixelOverlayState getState() const;
     void setState(const PixelOverlayState &state);
+
+    // opacity (0-255) used when blending in the Alpha state
+    uint8_t getOpacity() const { return opacity; }
+    void setOpacity(uint8_t o) { opacity = o; }
     
     void doOverlay(uint8_t *channels);
     
@@ -105,9 +119,12 @@ public:
     RunningEffect *getRunningEffect() const { return runningEffect; }
     
     int32_t updateRunningEffects();
+    // render time of the running effect's updates
+    void getEffectStatsJson(Json::Value &v);
 
 private:
     void setValue(uint8_t v, int startChannel = -1, int endChannel = -1);
+    void buildChannelMapSpans();
 
     
     
@@ -115,11 +132,23 @@ private:
     std::string name;
     int width, height;
     PixelOverlayState state;
+    uint8_t opacity;
     int startChannel;
     int channelCount;
     int channelsPerNode;
     
     std::vector<uint32_t> channelMap;
+
+    // runs of the channelMap where consecutive overlay buffer channels map
+    // to consecutive model channels so setData can copy them in one go,
+    // channels not in a long enough run are gathered one at a time
+    struct ChannelMapSpan {
+        uint32_t src;
+        uint32_t dst;
+        uint32_t len;
+    };
+    std::vector<ChannelMapSpan> channelMapSpans;
+    std::vector<std::pair<uint32_t, uint32_t>> channelMapGather;
     uint8_t      *channelData;
     
     struct OverlayBufferData {
@@ -132,4 +161,8 @@ private:
 
     std::mutex   effectLock;
     RunningEffect *runningEffect;
+    std::atomic_uint effectUpdateCount;
+    std::atomic_uint effectUpdateLastUS;
+    std::atomic_uint effectUpdateMaxUS;
+    std::atomic<uint64_t> effectUpdateTotalUS;
 };
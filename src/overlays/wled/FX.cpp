@@ -32,7 +32,7 @@
 #define IBN 5100
 #define PALETTE_SOLID_WRAP (paletteBlend == 1 || paletteBlend == 3)
 
-uint16_t rand16seed = rand();
+thread_local uint16_t rand16seed = rand();
 
 
 /*
@@ -3017,7 +3017,7 @@ uint16_t WS2812FX::mode_exploding_fireworks(void)
      */
     int nSparks = flare->pos;
     nSparks = constrain(nSparks, 0, numSparks);
-    static float dying_gravity;
+    float &dying_gravity = _fireworksDyingGravity;
   
     // initialize sparks
     if (SEGENV.aux0 == 2) {
@@ -3433,7 +3433,7 @@ uint16_t WS2812FX::phased_base(uint8_t moder) {                  // We're making
 
   uint8_t allfreq = 16;                                          // Base frequency.
   //float* phasePtr = reinterpret_cast<float*>(SEGENV.step);       // Phase change value gets calculated.
-  static float phase = 0;//phasePtr[0];
+  float &phase = _phasedBasePhase;//phasePtr[0];
   uint8_t cutOff = (255-SEGMENT.intensity);                      // You can change the number of pixels.  AKA INTENSITY (was 192).
   uint8_t modVal = 5;//SEGMENT.fft1/8+1;                         // You can change the modulus. AKA FFT1 (was 5).
 
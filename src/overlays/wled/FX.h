@@ -58,7 +58,9 @@ inline uint32_t GET_MILLIS() {
 inline void cleanup_R1() {
 }
 
-extern uint16_t rand16seed;
+// effects on different models are rendered on different threads, each
+// thread gets its own random sequence
+extern thread_local uint16_t rand16seed;
 #define FASTLED_RAND16_2053  ((uint16_t)(2053))
 #define FASTLED_RAND16_13849 ((uint16_t)(13849))
 #define APPLY_FASTLED_RAND16_2053(x) (x * FASTLED_RAND16_2053)
@@ -624,7 +626,8 @@ class WS2812FX {
   // pre show callback
   typedef void (*show_callback) (void);
 
-  static WS2812FX* instance;
+  // the strip being set up or serviced on this thread
+  static thread_local WS2812FX* instance;
   
   // segment parameters
   public:
@@ -1179,6 +1182,9 @@ class WS2812FX {
     uint16_t _length, _lengthRaw, _virtualSegmentLength;
     uint16_t _rand16seed;
     uint8_t _brightness;
+    // per instance state for effects that used function statics
+    float _phasedBasePhase = 0;
+    float _fireworksDyingGravity = 0;
     uint16_t _usedSegmentData = 0;
     uint16_t _transitionDur = 750;
 
@@ -1256,6 +1262,7 @@ class WS2812FX {
 public:
     WS2812FX(PixelOverlayModel *m, int mapping);
     void BusSetPixelColor(uint16_t indexPixel, RgbwColor c);
+    void BusFillPixelColor(uint16_t indexPixel, uint16_t count, RgbwColor c);
     void BusSetBrightness(uint8_t b);
     RgbwColor BusGetPixelColorRaw(uint16_t indexPixel);
     uint32_t BusGetPixelColorRgbw(uint16_t indexPixel);
@@ -1267,6 +1274,10 @@ public:
     uint8_t brightnessValues[256];
     uint8_t lastBrightness;
     int mapping = 0;
+
+    // unscaled RGB per pixel and the offset of each pixel in the overlay buffer
+    std::vector<uint8_t> pixels;
+    std::vector<uint32_t> pixelOffsets;
 };
 
 //10 names per line
@@ -74,6 +74,7 @@ void WS2812FX::init(bool supportWhite, uint16_t countPixels, bool skipFirst)
 }
 
 void WS2812FX::service() {
+  WS2812FX::instance = this;
   uint32_t nowUp = millis(); // Be aware, millis() rolls over every 49 days
   now = nowUp + timebase;
   if (nowUp - _lastShow < MIN_SHOW_DELAY) return;
@@ -645,6 +646,21 @@ uint32_t WS2812FX::color_blend(uint32_t color1, uint32_t color2, uint16_t blend,
  * Fills segment with color
  */
 void WS2812FX::fill(uint32_t c) {
+#ifndef WLED_CUSTOM_LED_MAPPING
+  // A solid color covers every pixel of an ungrouped segment no matter
+  // how it is reversed or mirrored so write the whole range as one span
+  if (SEGLEN && SEGMENT.grouping == 1 && SEGMENT.spacing == 0 && !_useRgbw && !_skipFirstMode) {
+    RgbwColor col((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, 0);
+    if (_bri_t < 255) {
+      col.R = scale8(col.R, _bri_t);
+      col.G = scale8(col.G, _bri_t);
+      col.B = scale8(col.B, _bri_t);
+    }
+    uint16_t start = reverseMode ? (_length - SEGMENT.stop) : SEGMENT.start;
+    BusFillPixelColor(start, SEGMENT.length(), col);
+    return;
+  }
+#endif
   for(uint16_t i = 0; i < SEGLEN; i++) {
     setPixelColor(i, c);
   }
@@ -1043,7 +1059,7 @@ uint32_t WS2812FX::gamma32(uint32_t color)
   return ((w << 24) | (r << 16) | (g << 8) | (b));
 }
 
-WS2812FX* WS2812FX::instance = nullptr;
+thread_local WS2812FX* WS2812FX::instance = nullptr;
 
 
 
@@ -1099,26 +1115,59 @@ void WS2812FX::mapXY(uint16_t indexPixel, int &x, int &y) {
     }
 }
 
+// WLED draws into a linear RGB buffer indexed by pixel number with the
+// colors as the effect set them.  Brightness and the mapping onto the
+// model's layout are only applied once per frame when it's shown.
 void WS2812FX::BusSetPixelColor(uint16_t indexPixel, RgbwColor c) {
-    int x, y;
-    mapXY(indexPixel, x, y);
-    model->setOverlayPixelValue(x, y, brightnessValues[c.R], brightnessValues[c.G], brightnessValues[c.B]);
+    if (indexPixel >= pixelOffsets.size()) {
+        return;
+    }
+    uint8_t *p = &pixels[indexPixel * 3];
+    p[0] = c.R;
+    p[1] = c.G;
+    p[2] = c.B;
+}
+void WS2812FX::BusFillPixelColor(uint16_t indexPixel, uint16_t count, RgbwColor c) {
+    size_t end = std::min((size_t)indexPixel + count, pixelOffsets.size());
+    if (indexPixel >= end) {
+        return;
+    }
+    uint8_t *p = &pixels[indexPixel * 3];
+    uint8_t *pend = &pixels[end * 3];
+    if (c.R == c.G && c.G == c.B) {
+        memset(p, c.R, pend - p);
+        return;
+    }
+    for (; p < pend; p += 3) {
+        p[0] = c.R;
+        p[1] = c.G;
+        p[2] = c.B;
+    }
 }
 RgbwColor WS2812FX::BusGetPixelColorRaw(uint16_t indexPixel) {
-    int x, y;
-    mapXY(indexPixel, x, y);
-    int r, g, b;
-    model->getOverlayPixelValue(x, y, r, g, b);
-    return RgbwColor(r, g, b, 0);
+    if (indexPixel >= pixelOffsets.size()) {
+        return RgbwColor(0, 0, 0, 0);
+    }
+    const uint8_t *p = &pixels[indexPixel * 3];
+    return RgbwColor(p[0], p[1], p[2], 0);
 }
 uint32_t WS2812FX::BusGetPixelColorRgbw(uint16_t indexPixel) {
-    int x, y;
-    mapXY(indexPixel, x, y);
-    int r, g, b;
-    model->getOverlayPixelValue(x, y, r, g, b);
-    return (r << 16) | (g << 8) | b;
+    if (indexPixel >= pixelOffsets.size()) {
+        return 0;
+    }
+    const uint8_t *p = &pixels[indexPixel * 3];
+    return (p[0] << 16) | (p[1] << 8) | p[2];
 }
 void WS2812FX::DoShow() {
+    uint8_t *buf = model->getOverlayBuffer();
+    const uint8_t *p = pixels.data();
+    for (auto offset : pixelOffsets) {
+        uint8_t *dst = &buf[offset];
+        dst[0] = brightnessValues[p[0]];
+        dst[1] = brightnessValues[p[1]];
+        dst[2] = brightnessValues[p[2]];
+        p += 3;
+    }
     model->flushOverlayBuffer();
 }
 WS2812FX::WS2812FX(PixelOverlayModel *m, int h) : WS2812FX() {
@@ -1130,5 +1179,14 @@ WS2812FX::WS2812FX(PixelOverlayModel *m, int h) : WS2812FX() {
     lastBrightness = 0;
     BusSetBrightness(128);
     mapping = h;
+
+    // precompute where each pixel lands in the overlay buffer
+    pixels.resize(i * 3);
+    pixelOffsets.resize(i);
+    for (int p = 0; p < i; p++) {
+        int x, y;
+        mapXY(p, x, y);
+        pixelOffsets[p] = (y * model->getWidth() + x) * 3;
+    }
     init(false, i, false);
 }
@@ -465,6 +465,9 @@ Json::Value PlaylistEntryMedia::GetConfig(void)
 	result["minutesTotal"]        = status.minutesTotal;
 	result["secondsTotal"]        = status.secondsTotal;
 	result["mediaSeconds"]        = status.mediaSeconds;
+	result["videoFramesDecoded"]  = status.videoFramesDecoded;
+	result["videoFramesDropped"]  = status.videoFramesDropped;
+	result["videoFramesLate"]     = status.videoFramesLate;
 
 	return result;
 }
@@ -0,0 +1,176 @@
+/*
+ *   ChannelDataCompare - vectorized compare/copy of channel data blocks
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHANNELDATA_X86
+#endif
+
+#include "ChannelDataCompare.h"
+
+// Each kernel only has to find the block containing the first difference,
+// the differs/copyIfDifferent entry points are built on top of that.  The
+// returned offset is the start of that block (<= the first differing byte)
+// or len if the buffers are identical.
+typedef size_t (*FindFirstDiffFunc)(const uint8_t *a, const uint8_t *b, size_t len);
+
+template<FindFirstDiffFunc FIND>
+static bool KernelDiffers(const uint8_t *a, const uint8_t *b, size_t len) {
+    return FIND(a, b, len) < len;
+}
+
+template<FindFirstDiffFunc FIND>
+static bool KernelCopyIfDifferent(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t off = FIND(dst, src, len);
+    if (off >= len) {
+        return false;
+    }
+    memcpy(dst + off, src + off, len - off);
+    return true;
+}
+
+static inline uint64_t LoadU64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static size_t FindFirstDiffScalar(const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t x = 0;
+    for (; x + 32 <= len; x += 32) {
+        uint64_t d = (LoadU64(a + x) ^ LoadU64(b + x))
+                   | (LoadU64(a + x + 8) ^ LoadU64(b + x + 8))
+                   | (LoadU64(a + x + 16) ^ LoadU64(b + x + 16))
+                   | (LoadU64(a + x + 24) ^ LoadU64(b + x + 24));
+        if (d) {
+            return x;
+        }
+    }
+    for (; x + 8 <= len; x += 8) {
+        if (LoadU64(a + x) != LoadU64(b + x)) {
+            return x;
+        }
+    }
+    for (; x < len; x++) {
+        if (a[x] != b[x]) {
+            return x;
+        }
+    }
+    return len;
+}
+
+#ifdef CHANNELDATA_X86
+__attribute__((target("sse2")))
+static size_t FindFirstDiffSSE2(const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t x = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 64 <= len; x += 64) {
+        __m128i d0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + x)),
+                                   _mm_loadu_si128((const __m128i*)(b + x)));
+        __m128i d1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + x + 16)),
+                                   _mm_loadu_si128((const __m128i*)(b + x + 16)));
+        __m128i d2 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + x + 32)),
+                                   _mm_loadu_si128((const __m128i*)(b + x + 32)));
+        __m128i d3 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + x + 48)),
+                                   _mm_loadu_si128((const __m128i*)(b + x + 48)));
+        __m128i d = _mm_or_si128(_mm_or_si128(d0, d1), _mm_or_si128(d2, d3));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, zero)) != 0xFFFF) {
+            return x;
+        }
+    }
+    for (; x + 16 <= len; x += 16) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + x)),
+                                    _mm_loadu_si128((const __m128i*)(b + x)));
+        if (_mm_movemask_epi8(eq) != 0xFFFF) {
+            return x;
+        }
+    }
+    return x + FindFirstDiffScalar(a + x, b + x, len - x);
+}
+
+__attribute__((target("avx2")))
+static size_t FindFirstDiffAVX2(const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t x = 0;
+    for (; x + 128 <= len; x += 128) {
+        __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + x)),
+                                      _mm256_loadu_si256((const __m256i*)(b + x)));
+        __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + x + 32)),
+                                      _mm256_loadu_si256((const __m256i*)(b + x + 32)));
+        __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + x + 64)),
+                                      _mm256_loadu_si256((const __m256i*)(b + x + 64)));
+        __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + x + 96)),
+                                      _mm256_loadu_si256((const __m256i*)(b + x + 96)));
+        __m256i d = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+        if (!_mm256_testz_si256(d, d)) {
+            return x;
+        }
+    }
+    for (; x + 32 <= len; x += 32) {
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + x)),
+                                     _mm256_loadu_si256((const __m256i*)(b + x)));
+        if (!_mm256_testz_si256(d, d)) {
+            return x;
+        }
+    }
+    return x + FindFirstDiffScalar(a + x, b + x, len - x);
+}
+#endif
+
+static std::vector<ChannelDataCompareKernel> BuildKernelList() {
+    std::vector<ChannelDataCompareKernel> kernels;
+    kernels.push_back({ "scalar",
+                        KernelDiffers<FindFirstDiffScalar>,
+                        KernelCopyIfDifferent<FindFirstDiffScalar> });
+#ifdef CHANNELDATA_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back({ "sse2",
+                            KernelDiffers<FindFirstDiffSSE2>,
+                            KernelCopyIfDifferent<FindFirstDiffSSE2> });
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({ "avx2",
+                            KernelDiffers<FindFirstDiffAVX2>,
+                            KernelCopyIfDifferent<FindFirstDiffAVX2> });
+    }
+#endif
+    ChannelDataCompareKernel neon;
+    if (GetNEONChannelDataCompareKernel(neon)) {
+        kernels.push_back(neon);
+    }
+    return kernels;
+}
+
+const std::vector<ChannelDataCompareKernel> &GetChannelDataCompareKernels() {
+    static const std::vector<ChannelDataCompareKernel> kernels = BuildKernelList();
+    return kernels;
+}
+
+static const ChannelDataCompareKernel &GetBestKernel() {
+    static const ChannelDataCompareKernel &best = GetChannelDataCompareKernels().back();
+    return best;
+}
+
+bool ChannelDataDiffers(const uint8_t *a, const uint8_t *b, size_t len) {
+    return GetBestKernel().differs(a, b, len);
+}
+
+bool ChannelDataCopyIfDifferent(uint8_t *dst, const uint8_t *src, size_t len) {
+    return GetBestKernel().copyIfDifferent(dst, src, len);
+}
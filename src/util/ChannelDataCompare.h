@@ -0,0 +1,43 @@
+#pragma once
+/*
+ *   ChannelDataCompare - vectorized compare/copy of channel data blocks
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Returns true if the first len bytes of a and b are not identical
+bool ChannelDataDiffers(const uint8_t *a, const uint8_t *b, size_t len);
+
+// Copies len bytes from src to dst, only writing the part of dst from the
+// first differing block onward.  Returns true if dst was modified.
+bool ChannelDataCopyIfDifferent(uint8_t *dst, const uint8_t *src, size_t len);
+
+class ChannelDataCompareKernel {
+public:
+    const char *name;
+    bool (*differs)(const uint8_t *a, const uint8_t *b, size_t len);
+    bool (*copyIfDifferent)(uint8_t *dst, const uint8_t *src, size_t len);
+};
+
+// All the kernels usable on this CPU, the portable one first and the one
+// used by ChannelDataDiffers/ChannelDataCopyIfDifferent last
+const std::vector<ChannelDataCompareKernel> &GetChannelDataCompareKernels();
+
+// Implemented in ChannelDataCompareNEON.cpp which is built with the
+// compiler flags needed for NEON, returns false if NEON is not available
+bool GetNEONChannelDataCompareKernel(ChannelDataCompareKernel &kernel);
@@ -0,0 +1,82 @@
+/*
+ *   ChannelDataCompare micro-benchmark
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ChannelDataCompare.h"
+
+// Buffer sizes of a single universe, a typical pixel controller, a large
+// show and the maximum FPP channel count
+static const size_t BENCH_SIZES[] = { 512, 64 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+
+// Amount of data to run through each kernel for each measurement
+static const double BENCH_BYTES = 2.0 * 1024 * 1024 * 1024;
+
+static volatile int sink = 0;
+
+// called through a volatile pointer so the compiler can't hoist the
+// memcmp out of the timing loop
+static int (*volatile memcmpFunc)(const void *, const void *, size_t) = memcmp;
+
+template<class F>
+static double RunBenchmark(size_t len, F f) {
+    int iterations = (int)(BENCH_BYTES / len);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    f(); // warm the caches
+    auto start = std::chrono::steady_clock::now();
+    int changed = 0;
+    for (int i = 0; i < iterations; i++) {
+        changed += f();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    sink = changed;
+    return (double)len * iterations / elapsed.count() / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    for (size_t len : BENCH_SIZES) {
+        std::vector<uint8_t> a(len), b(len), c(len);
+        for (size_t x = 0; x < len; x++) {
+            a[x] = (uint8_t)(rand() & 0xFF);
+        }
+        b = a;
+
+        printf("%zu bytes\n", len);
+        double gbps = RunBenchmark(len, [&]() { return memcmpFunc(a.data(), b.data(), len) != 0; });
+        printf("    %-8s differs %7.2f GB/s\n", "memcmp", gbps);
+
+        for (auto &k : GetChannelDataCompareKernels()) {
+            // identical buffers are the worst case for the compare, the
+            // whole buffer has to be scanned
+            double differs = RunBenchmark(len, [&]() { return k.differs(a.data(), b.data(), len); });
+            double copySame = RunBenchmark(len, [&]() { return k.copyIfDifferent(b.data(), a.data(), len); });
+            // change the last byte every time so the tail is always copied
+            double copyTail = RunBenchmark(len, [&]() { b[len - 1]++; return k.copyIfDifferent(b.data(), a.data(), len); });
+            // change the first byte every time so the whole buffer is copied
+            double copyAll = RunBenchmark(len, [&]() { c[0]++; return k.copyIfDifferent(c.data(), a.data(), len); });
+            printf("    %-8s differs %7.2f GB/s   copy(same) %7.2f GB/s   copy(tail) %7.2f GB/s   copy(all) %7.2f GB/s\n",
+                   k.name, differs, copySame, copyTail, copyAll);
+        }
+    }
+    return 0;
+}
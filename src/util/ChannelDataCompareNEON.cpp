@@ -0,0 +1,97 @@
+/*
+ *   ChannelDataCompare - NEON kernel
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with -mfpu=neon on 32bit ARM (see fpp_so.mk) so
+// nothing in here may be called without checking HWCAP_NEON first.
+
+#include <cstring>
+
+#include "ChannelDataCompare.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#ifndef __aarch64__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static inline bool AnyNonZero(uint8x16_t v) {
+#ifdef __aarch64__
+    return vmaxvq_u8(v) != 0;
+#else
+    uint8x8_t d = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+    return vget_lane_u64(vreinterpret_u64_u8(d), 0) != 0;
+#endif
+}
+
+static size_t FindFirstDiffNEON(const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t x = 0;
+    for (; x + 64 <= len; x += 64) {
+        uint8x16_t d0 = veorq_u8(vld1q_u8(a + x), vld1q_u8(b + x));
+        uint8x16_t d1 = veorq_u8(vld1q_u8(a + x + 16), vld1q_u8(b + x + 16));
+        uint8x16_t d2 = veorq_u8(vld1q_u8(a + x + 32), vld1q_u8(b + x + 32));
+        uint8x16_t d3 = veorq_u8(vld1q_u8(a + x + 48), vld1q_u8(b + x + 48));
+        if (AnyNonZero(vorrq_u8(vorrq_u8(d0, d1), vorrq_u8(d2, d3)))) {
+            return x;
+        }
+    }
+    for (; x + 16 <= len; x += 16) {
+        if (AnyNonZero(veorq_u8(vld1q_u8(a + x), vld1q_u8(b + x)))) {
+            return x;
+        }
+    }
+    for (; x < len; x++) {
+        if (a[x] != b[x]) {
+            return x;
+        }
+    }
+    return len;
+}
+
+static bool DiffersNEON(const uint8_t *a, const uint8_t *b, size_t len) {
+    return FindFirstDiffNEON(a, b, len) < len;
+}
+
+static bool CopyIfDifferentNEON(uint8_t *dst, const uint8_t *src, size_t len) {
+    size_t off = FindFirstDiffNEON(dst, src, len);
+    if (off >= len) {
+        return false;
+    }
+    memcpy(dst + off, src + off, len - off);
+    return true;
+}
+
+bool GetNEONChannelDataCompareKernel(ChannelDataCompareKernel &kernel) {
+#ifndef __aarch64__
+    if (!(getauxval(AT_HWCAP) & HWCAP_NEON)) {
+        return false;
+    }
+#endif
+    kernel.name = "neon";
+    kernel.differs = DiffersNEON;
+    kernel.copyIfDifferent = CopyIfDifferentNEON;
+    return true;
+}
+
+#else
+
+bool GetNEONChannelDataCompareKernel(ChannelDataCompareKernel &kernel) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ *   Worker thread pool for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "fpp-pch.h"
+
+#include <pthread.h>
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(const std::string &n, int threads)
+    : name(n), nextWorker(0), queued(0), pending(0), running(true) {
+    if (threads <= 0) {
+        threads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    for (int x = 0; x < threads; x++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int x = 0; x < threads; x++) {
+        workers[x]->thread = std::thread(&WorkerPool::runWorker, this, x);
+        // thread names are limited to 15 characters
+        std::string tname = name.substr(0, 12) + "-" + std::to_string(x);
+        pthread_setname_np(workers[x]->thread.native_handle(), tname.substr(0, 15).c_str());
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::unique_lock<std::mutex> l(poolLock);
+        running = false;
+    }
+    workCV.notify_all();
+    for (auto &w : workers) {
+        w->thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> &&task) {
+    pending++;
+    Worker *w = workers[nextWorker++ % workers.size()].get();
+    {
+        std::unique_lock<std::mutex> l(w->lock);
+        w->tasks.push_back(std::move(task));
+    }
+    queued++;
+    std::unique_lock<std::mutex> l(poolLock);
+    workCV.notify_one();
+}
+
+void WorkerPool::wait() {
+    std::unique_lock<std::mutex> l(poolLock);
+    doneCV.wait(l, [this]() { return pending == 0; });
+}
+
+bool WorkerPool::popTask(int idx, std::function<void()> &task) {
+    int count = workers.size();
+    for (int x = 0; x < count; x++) {
+        Worker *w = workers[(idx + x) % count].get();
+        std::unique_lock<std::mutex> l(w->lock);
+        if (!w->tasks.empty()) {
+            if (x == 0) {
+                // our own queue, newest first while it's still in cache
+                task = std::move(w->tasks.back());
+                w->tasks.pop_back();
+            } else {
+                // steal the oldest task from someone else
+                task = std::move(w->tasks.front());
+                w->tasks.pop_front();
+            }
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::runWorker(int idx) {
+    while (true) {
+        std::function<void()> task;
+        if (popTask(idx, task)) {
+            task();
+            if (--pending == 0) {
+                std::unique_lock<std::mutex> l(poolLock);
+                doneCV.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> l(poolLock);
+        workCV.wait(l, [this]() { return !running || queued > 0; });
+        if (!running && queued <= 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ *   Worker thread pool for Falcon Player (FPP)
+ *
+ *   The Falcon Player (FPP) is free software; you can redistribute it
+ *   and/or modify it under the terms of the GNU General Public License
+ *   as published by the Free Software Foundation; either version 2 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads.  Each worker has its own task queue;
+// submitted tasks are spread across the queues and an idle worker steals
+// from the other queues once its own is empty, so one slow task doesn't
+// hold up the tasks queued behind it.
+class WorkerPool {
+public:
+    // threads <= 0 creates one worker per core
+    WorkerPool(const std::string &name, int threads = 0);
+    ~WorkerPool();
+
+    int getThreadCount() const { return workers.size(); }
+
+    void submit(std::function<void()> &&task);
+
+    // Blocks until every task submitted so far has completed.  Must not be
+    // called from within a task.
+    void wait();
+
+private:
+    class Worker {
+    public:
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+    bool popTask(int idx, std::function<void()> &task);
+    void runWorker(int idx);
+
+    std::string name;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic_uint nextWorker;
+    std::atomic_int queued;
+    std::atomic_int pending;
+
+    std::mutex poolLock;
+    std::condition_variable workCV;
+    std::condition_variable doneCV;
+    bool running;
+};
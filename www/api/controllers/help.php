@@ -50,7 +50,7 @@ function help_help()
         [ 'GET /overlays/model/:ModelName', 'Gets the given overlay model and it\'s state', '', '{"ChannelCount":6144,"Name":"Matrix","Orientation":"horizontal","StartChannel":1,"StartCorner":"TL","StrandsPerString":1,"StringCount":32,"isActive":0}'],
         [ 'GET /overlays/model/:ModelName/clear', 'Clears the given model', '', 'OK'],
         [ 'GET /overlays/model/:ModelName/data', 'Gets the current channel data for the model', '', '{"data":[0,0,0,0,0,0],"isLocked":false}'],
-        [ 'PUT /overlays/model/:ModelName/state', 'Sets the state of the overlay model', '{"State": 1}', 'OK'],
+        [ 'PUT /overlays/model/:ModelName/state', 'Sets the state of the overlay model (0 - Disabled, 1 - Enabled, 2 - Transparent, 3 - Transparent RGB, 4 - Additive, 5 - Maximum, 6 - Alpha).  Opacity (0-255) is optional and used by the Alpha state', '{"State": 6, "Opacity": 128}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/fill', 'Fills the entire overlay with the given color', '{"RGB": [255, 0, 0]}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/pixel', 'Sets a specific pixel in the model to the given color', '{"X": 10, "Y": 12, "RGB": [255, 0, 0]}', 'OK'],
         [ 'PUT /overlays/model/:ModelName/text', 'Displays text on the overlay model', '{"Message": "Hello", "Position": "L2R", "Font": "Helvetica", "FontSize": 12, "AntiAlias": false, "PixelsPerSecond": 5, "Color": "#FF000", "AutoEnable": false}', 'OK'],
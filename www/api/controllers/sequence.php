@@ -85,14 +85,26 @@ function PostSequence() {
         $file = $file . ".fseq";
     }
     
+    // fppd memory maps the sequence it's playing, so never rewrite a
+    // sequence in place.  Write a temporary file and rename it over the
+    // old one so a playing copy keeps reading the old file.
+    $tmpFile = $file . ".tmp";
     $putdata = fopen("php://input", "r");
-    $fp = fopen($file, "w");
+    $fp = fopen($tmpFile, "w");
     while ($data = fread($putdata, 1024*16)) {
         fwrite($fp, $data);
     }
     fclose($fp);
     fclose($putdata);
 
+    if (!rename($tmpFile, $file)) {
+        unlink($tmpFile);
+        $resp = Array();
+        $resp['Status'] = 'Error';
+        $resp['Message'] = 'Could not save sequence ' . $sequence;
+        return json($resp);
+    }
+
     $resp = Array();
     $resp['Status'] = 'OK';
     $resp['Message'] = '';
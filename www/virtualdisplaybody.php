@@ -1,8 +1,6 @@
 <script type="text/javascript" src="jquery/jcanvas.js"></script>
 <script>
-var cellColors = [];
 var scaleMap = [];
-var base64 = [];
 <?
 // 16:9 canvas by default, but can be overwridden in wrapper script
 if (!isset($canvasWidth))
@@ -11,11 +9,14 @@ if (!isset($canvasWidth))
 if (!isset($canvasHeight))
 	$canvasHeight = 576;
 
-$base64 = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz+/"; // Base64 index table
-for ($i = 0; $i < 64; $i++)
+// Pass any view options on to fppd, ie. virtualdisplay.php?fps=10&scale=2
+$streamArgs = Array();
+foreach (Array('fps', 'x', 'y', 'w', 'h', 'scale') as $arg)
 {
-	printf("base64['%s'] = '%02X';\n", substr($base64, $i, 1), $i << 2);
+	if (isset($_GET[$arg]))
+		$streamArgs[$arg] = intval($_GET[$arg]);
 }
+$streamScale = isset($streamArgs['scale']) ? max(1, $streamArgs['scale']) : 1;
 
 $f = fopen($settings['configDirectory'] . '/virtualdisplaymap', "r");
 if ($f) {
@@ -47,7 +48,7 @@ if ($f) {
 		$line = trim($line);
 		$entry = explode(",", $line, 6);
 
-		$ox = $entry[0];
+		$ox = (int)$entry[0];
 		$oy = $previewHeight - $entry[1];
 		$oz = $entry[2];
 		$x = (int)($ox * $scale);
@@ -57,24 +58,13 @@ if ($f) {
 		$colors = $entry[4];
 		$iy = $canvasHeight - $y;
 
-		if (($ox >= 4096) || ($oy >= 4096))
-			$key = substr($base64, ($ox >> 12) & 0x3f, 1) .
-					substr($base64, ($ox >> 6) & 0x3f, 1) .
-					substr($base64, $ox & 0x3f, 1) .
-					substr($base64, ($oy >> 12) & 0x3f, 1) .
-					substr($base64, ($oy >> 6) & 0x3f, 1) .
-					substr($base64, $oy & 0x3f, 1);
-		else
-			$key = substr($base64, ($ox >> 6) & 0x3f, 1) .
-					substr($base64, $ox & 0x3f, 1) .
-					substr($base64, ($oy >> 6) & 0x3f, 1) .
-					substr($base64, $oy & 0x3f, 1);
+		// matches the x,y location sent by fppd for each changed pixel
+		$key = $ox . ',' . $oy;
 
 		if (!isset($scaleMap[$key]))
 		{
 			$scaleMap[$key] = 1;
 			echo "scaleMap['" . $key . "'] = { x: $x, y: $y, ox: $ox, oy: $oy };\n";
-			echo "cellColors['$x,$y'] = { x: $x, y: $y, color: '#000000'};\n";
 		}
 	}
 	fclose($f);
@@ -84,10 +74,13 @@ if ($f) {
 
 var canvasWidth = <? echo $canvasWidth; ?>;
 var canvasHeight = <? echo $canvasHeight; ?>;
-var evtSource;
+var streamArgs = '<? echo http_build_query($streamArgs); ?>';
+var streamScale = <? echo $streamScale; ?>;
+var streamAbort;
 var ctx;
 var buffer;
 var bctx;
+var bImage;
 
 $.jCanvas.defaults.fromCenter = false;
 
@@ -121,75 +114,183 @@ function initCanvas()
 	buffer.height = c.height;
 	bctx = buffer.getContext('2d');
 
-	// Draw the black pixels
-	bctx.fillStyle = '#000000';
-	for (var key in cellColors)
+	// Start with all pixels black, everything else stays transparent so
+	// the background shows through.  Each pixel's offset in the image
+	// data is stored in the scaleMap so updates can write it directly.
+	bImage = bctx.createImageData(buffer.width, buffer.height);
+	for (var key in scaleMap)
 	{
-		bctx.fillRect(cellColors[key].x, cellColors[key].y, 1, 1);
+		var s = scaleMap[key];
+		if ((s.x < 0) || (s.x >= buffer.width) || (s.y < 0) || (s.y >= buffer.height))
+		{
+			s.offset = -1;
+			continue;
+		}
+
+		s.offset = (s.y * buffer.width + s.x) * 4;
+		bImage.data[s.offset + 3] = 255;
+	}
+	bctx.putImageData(bImage, 0, 0);
+
+	// When downscaled fppd only sends one pixel per block, draw its color
+	// on every pixel in the block
+	for (var key in scaleMap)
+	{
+		var s = scaleMap[key];
+		s.block = [ s ];
+	}
+	if (streamScale > 1)
+	{
+		var blocks = {};
+		for (var key in scaleMap)
+		{
+			var s = scaleMap[key];
+			var bkey = Math.floor(s.ox / streamScale) + ',' + Math.floor(s.oy / streamScale);
+			if (!(bkey in blocks))
+				blocks[bkey] = [];
+
+			blocks[bkey].push(s);
+			s.block = blocks[bkey];
+		}
 	}
 }
 
-function processEvent(e)
+// Draws all complete frames in data and returns the leftover bytes of a
+// partial frame.  Each frame is a little endian uint32 pixel count
+// followed by x (uint16), y (uint16), r, g, b for each changed pixel.
+function processFrames(data)
 {
-	var pixels = e.data.split('|');
+	var view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+	var pos = 0;
+	var drawn = false;
+	var pixels = bImage.data;
 
-	for (i = 0; i < pixels.length; i++)
+	while ((pos + 4) <= data.length)
 	{
-		// color:pixel;pixel;pixel|color:pixel|color:pixel;pixel
-		var data = pixels[i].split(':');
+		var count = view.getUint32(pos, true);
+		var end = pos + 4 + (count * 7);
+		if (end > data.length)
+			break;
 
-		var rgb = data[0];
+		for (var p = pos + 4; p < end; p += 7)
+		{
+			var s = scaleMap[view.getUint16(p, true) + ',' + view.getUint16(p + 2, true)];
+			if (!s)
+				continue;
+
+			for (var b = 0; b < s.block.length; b++)
+			{
+				var offset = s.block[b].offset;
+				if (offset < 0)
+					continue;
+
+				pixels[offset] = data[p + 4];
+				pixels[offset + 1] = data[p + 5];
+				pixels[offset + 2] = data[p + 6];
+			}
+		}
 
-		var r = base64[rgb.substring(0,1)];
-		var g = base64[rgb.substring(1,2)];
-		var b = base64[rgb.substring(2,3)];
+		pos = end;
+		drawn = true;
+	}
 
-		bctx.fillStyle = '#' + r + g + b;
+	if (drawn)
+	{
+		bctx.putImageData(bImage, 0, 0);
+		ctx.drawImage(buffer, 0, 0);
+	}
 
-		// Uncomment to see the incoming color and location data in real time
-		// $('#data').html(bctx.fillStyle + ' => ' + data[1] + '<br>' + $('#data').html().substring(0,500));
+	return data.subarray(pos);
+}
 
-		var locs = data[1].split(';');
-		for (j = 0; j < locs.length; j++)
-		{
-			var s = scaleMap[locs[j]];
+// Reconnect delay in ms, doubled after each failed attempt and reset
+// once data is received again
+var reconnectDelay = 1000;
+var reconnectTimer = null;
 
-			bctx.fillRect(s.x, s.y, 1, 1);
-		}
-	}
-	ctx.drawImage(buffer, 0, 0);
+function reconnectStream()
+{
+	if (streamAbort.signal.aborted || reconnectTimer)
+		return;
+
+	reconnectTimer = setTimeout(function() {
+		reconnectTimer = null;
+		startStream();
+	}, reconnectDelay);
+	reconnectDelay = Math.min(reconnectDelay * 2, 30000);
 }
 
-function startSSE()
+function startStream()
 {
-	evtSource = new EventSource('//<?php echo $_SERVER['SERVER_ADDR'] ?>:32328/');
-
-	evtSource.onmessage = function(event) {
-		processEvent(event);
-	};
+	streamAbort = new AbortController();
+
+	fetch('//<?php echo $_SERVER['SERVER_ADDR'] ?>:32328/?' + streamArgs, { signal: streamAbort.signal })
+		.then(function(response) {
+			var reader = response.body.getReader();
+			var pending = new Uint8Array(0);
+
+			function readChunk() {
+				return reader.read().then(function(result) {
+					if (result.done)
+					{
+						// fppd closed the stream, possibly because
+						// we fell too far behind or it restarted
+						reconnectStream();
+						return;
+					}
+
+					reconnectDelay = 1000;
+
+					var data = result.value;
+					if (pending.length)
+					{
+						data = new Uint8Array(pending.length + result.value.length);
+						data.set(pending);
+						data.set(result.value, pending.length);
+					}
+					pending = processFrames(data).slice();
+
+					return readChunk();
+				});
+			}
+
+			return readChunk();
+		})
+		.catch(function(e) {
+			if (e.name != 'AbortError')
+			{
+				console.log('Virtual Display stream error: ' + e);
+				reconnectStream();
+			}
+		});
 }
 
-function stopSSE()
+function stopStream()
 {
 	$('#stopButton').hide();
 
-	evtSource.close();
+	streamAbort.abort();
+	if (reconnectTimer)
+	{
+		clearTimeout(reconnectTimer);
+		reconnectTimer = null;
+	}
 }
 
-function setupSSEClient()
+function setupStreamClient()
 {
 	initCanvas();
 
-	startSSE();
+	startStream();
 }
 
 $(document).ready(function() {
-	setupSSEClient();
+	setupStreamClient();
 });
 
 </script>
 
-<input type='button' id='stopButton' onClick='stopSSE();' value='Stop Virtual Display'><br>
+<input type='button' id='stopButton' onClick='stopStream();' value='Stop Virtual Display'><br>
 <table border=0>
 <tr><td valign='top'>
 <canvas id='vCanvas' width='<? echo $canvasWidth; ?>' height='<? echo $canvasHeight; ?>'></canvas></td>